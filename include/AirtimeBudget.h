@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+
+// Token bucket limiting the time the radio spends off the home channel for background scans.
+// Tokens (ms of off-channel time) refill at percent/100 per ms up to one window's worth, e.g. 100 ms
+// for 10% of 1000 ms, so any window of that length sees about percent off-channel time.
+// A scan longer than the bucket (a full scan) waits for a full bucket and leaves a debt of at most
+// one window, which pauses background scans until it is repaid.
+// Also measures the off-channel time per window, for reporting; the reporting getters don't modify
+// the budget, so a status poll can't roll a window early.
+class AirtimeBudget {
+public:
+    struct Stats {
+        float tokensMs;
+        float lastWindowPercent;
+        float maxWindowPercent;
+        uint64_t offChannelTotalMs;
+        uint32_t deferred;
+    };
+
+    void configure(float percent, uint32_t windowMs) {
+        rate = percent / 100.0f;
+        window = windowMs;
+        capacity = rate * (float)windowMs;
+        if (tokens > capacity) {
+            tokens = capacity;
+        }
+    }
+
+    bool unlimited() const {
+        return rate >= 1.0f;
+    }
+
+    // True if a scan taking about costMs off-channel may start now.
+    bool allows(uint32_t nowMs, uint32_t costMs) {
+        refill(nowMs);
+        if (unlimited() || costMs == 0) {
+            return true;
+        }
+        const float needed = (float)costMs < capacity ? (float)costMs : capacity;
+        return tokens >= needed;
+    }
+
+    // Books usedMs of off-channel time that ended at nowMs.
+    void charge(uint32_t nowMs, uint32_t usedMs) {
+        refill(nowMs);
+        tokens -= (float)usedMs;
+        if (tokens < -(float)window) {
+            tokens = -(float)window;
+        }
+        totalMs += usedMs;
+        const uint32_t index = window ? nowMs / window : 0;
+        if (index != windowIndex) {
+            rollWindow(index);
+        }
+        currentWindowMs += usedMs;
+    }
+
+    void noteDeferred() {
+        deferredCount++;
+    }
+
+    float tokensMs(uint32_t nowMs) const {
+        const float refilled = tokens + (float)(nowMs - lastRefillMs) * rate;
+        return refilled > capacity ? capacity : refilled;
+    }
+    uint64_t offChannelTotalMs() const { return totalMs; }
+    uint32_t deferred() const { return deferredCount; }
+    // Off-channel time in the last completed window, and the most in any completed window, as a
+    // percentage of the window; as if the windows up to nowMs had been rolled.
+    float lastWindowPercent(uint32_t nowMs) const {
+        const uint32_t index = window ? nowMs / window : 0;
+        uint32_t lastMs = lastWindowMs;
+        if (index != windowIndex) {
+            lastMs = (index == windowIndex + 1) ? currentWindowMs : 0;
+        }
+        return window ? 100.0f * (float)lastMs / (float)window : 0.0f;
+    }
+    float maxWindowPercent(uint32_t nowMs) const {
+        const uint32_t index = window ? nowMs / window : 0;
+        const uint32_t maxMs = (index != windowIndex && currentWindowMs > maxWindowMs) ? currentWindowMs : maxWindowMs;
+        return window ? 100.0f * (float)maxMs / (float)window : 0.0f;
+    }
+    Stats stats(uint32_t nowMs) const {
+        return Stats{tokensMs(nowMs), lastWindowPercent(nowMs), maxWindowPercent(nowMs), totalMs, deferredCount};
+    }
+
+private:
+    float rate = 0.1f;
+    float capacity = 100.0f;
+    float tokens = 100.0f;
+    uint32_t window = 1000;
+    uint32_t lastRefillMs = 0;
+    uint64_t totalMs = 0;
+    uint32_t deferredCount = 0;
+    uint32_t windowIndex = 0;
+    uint32_t currentWindowMs = 0;
+    uint32_t lastWindowMs = 0;
+    uint32_t maxWindowMs = 0;
+
+    void refill(uint32_t nowMs) {
+        tokens += (float)(nowMs - lastRefillMs) * rate;
+        if (tokens > capacity) {
+            tokens = capacity;
+        }
+        lastRefillMs = nowMs;
+    }
+
+    void rollWindow(uint32_t index) {
+        // A window without any scan since the last one counts as empty
+        lastWindowMs = (index == windowIndex + 1) ? currentWindowMs : 0;
+        if (currentWindowMs > maxWindowMs) {
+            maxWindowMs = currentWindowMs;
+        }
+        currentWindowMs = 0;
+        windowIndex = index;
+    }
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "InfoElements.h"
+#include "WiFiChannels.h"
+
+// Everything a scoring function may weigh for one AP.
+struct ApScoreInput {
+    int8_t rssi;
+    uint8_t channel;
+    ApCapabilities caps;
+    uint8_t connectFailures; // recent failed connects to this BSSID
+    uint8_t dfsPenaltyDb;    // settings of the built-in scoring
+    uint8_t failPenaltyDb;   // per recent failure
+};
+
+// Score of one AP in dB-equivalent units, so it compares like an RSSI (autoRoamDeltaRssiDbm applies
+// unchanged). Higher is better; the parts add up to total.
+struct ApScore {
+    int16_t total;
+    int16_t rssi;
+    int16_t rate;      // link rate the PHY generation and channel width allow at this RSSI
+    int16_t load;      // advertised BSS Load
+    int16_t dfs;
+    int16_t failures;
+    uint16_t estRateMbps;
+};
+
+typedef ApScore (*ApScoreFunction)(const ApScoreInput& in);
+
+// Built-in scoring functions. A station of one spatial stream is assumed (ESP32-C5).
+class ApScoring {
+public:
+    static constexpr float RateDbPerDoubling = 3.0f; // a doubled link rate is worth 3 dB of RSSI
+    static constexpr float RateBaseMbps = 6.0f;      // lowest 5 GHz rate, scores 0
+    static constexpr float LoadMaxPenaltyDb = 10.0f; // fully utilised channel
+    static constexpr uint8_t LoadFreeStations = 10;  // associated stations before they cost anything
+    static constexpr uint8_t FailuresCounted = 3;
+
+    // RSSI alone, as ranked before scoring was added.
+    static ApScore rssiOnly(const ApScoreInput& in) {
+        ApScore score = {};
+        score.rssi = in.rssi;
+        score.total = in.rssi;
+        return score;
+    }
+
+    static ApScore multiFactor(const ApScoreInput& in) {
+        ApScore score = {};
+        score.rssi = in.rssi;
+        const float rateMbps = estimateRateMbps(in.rssi, in.caps);
+        score.estRateMbps = (uint16_t)lroundf(rateMbps);
+        score.rate = (int16_t)lroundf(RateDbPerDoubling * log2f(rateMbps / RateBaseMbps));
+        if (in.caps.flags & ApCapabilities::FlagBssLoad) {
+            float penalty = LoadMaxPenaltyDb * (float)in.caps.bssLoadUtil / 255.0f;
+            if (in.caps.bssLoadStations > LoadFreeStations) {
+                penalty += 0.25f * (float)(in.caps.bssLoadStations - LoadFreeStations);
+            }
+            score.load = (int16_t)-lroundf(penalty < 1.5f * LoadMaxPenaltyDb ? penalty : 1.5f * LoadMaxPenaltyDb);
+        }
+        score.dfs = isDfsChannel(in.channel) ? -(int16_t)in.dfsPenaltyDb : 0;
+        const uint8_t failures = in.connectFailures < FailuresCounted ? in.connectFailures : FailuresCounted;
+        score.failures = -(int16_t)(failures * in.failPenaltyDb);
+        score.total = score.rssi + score.rate + score.load + score.dfs + score.failures;
+        return score;
+    }
+
+    // Highest single-stream rate whose typical sensitivity rssi meets, for the AP's PHY and width.
+    // Sensitivities are for 20 MHz and rise 3 dB per doubling of the width; too weak for MCS 0 at the
+    // full width, the link is assumed to fall back to a narrower one.
+    static float estimateRateMbps(int rssi, const ApCapabilities& caps) {
+        static const int8_t legacyDbm[8] = {-82, -81, -79, -77, -74, -70, -66, -65};
+        static const float legacyMbps[8] = {6, 9, 12, 18, 24, 36, 48, 54};
+        static const int8_t mcsDbm[12] = {-82, -79, -77, -74, -70, -66, -65, -64, -59, -57, -54, -52};
+        static const float htMbps[10] = {6.5f, 13, 19.5f, 26, 39, 52, 58.5f, 65, 78, 86.7f};          // 0.8 us GI
+        static const float heMbps[12] = {8.6f, 17.2f, 25.8f, 34.4f, 51.6f, 68.8f, 77.4f, 86, 103.2f, 114.7f, 129, 143.4f};
+        if ((caps.phy & (ApCapabilities::PhyHt | ApCapabilities::PhyVht | ApCapabilities::PhyHe | ApCapabilities::PhyEht)) == 0) {
+            int i = 7;
+            while (i > 0 && rssi < legacyDbm[i]) {
+                i--;
+            }
+            return legacyMbps[i];
+        }
+        const bool he = (caps.phy & (ApCapabilities::PhyHe | ApCapabilities::PhyEht)) != 0;
+        const int maxMcs = he ? 11 : ((caps.phy & ApCapabilities::PhyVht) ? 9 : 7);
+        uint8_t width20 = 1;
+        if (caps.phy & (ApCapabilities::PhyVht | ApCapabilities::PhyHe | ApCapabilities::PhyEht)) {
+            width20 = caps.widthMhz20 ? caps.widthMhz20 : 1;
+        } else if (caps.widthMhz20 >= 2) {
+            width20 = 2; // HT tops out at 40 MHz
+        }
+        int widthDb = (width20 >= 8) ? 9 : (width20 >= 4) ? 6 : (width20 >= 2) ? 3 : 0;
+        while (width20 > 1 && rssi < mcsDbm[0] + widthDb) {
+            width20 /= 2;
+            widthDb -= 3;
+        }
+        int mcs = maxMcs;
+        while (mcs > 0 && rssi < mcsDbm[mcs] + widthDb) {
+            mcs--;
+        }
+        // Data subcarriers relative to 20 MHz: 108/52, 234/52, 468/52
+        const float widthFactor = (width20 >= 8) ? 9.0f : (width20 >= 4) ? 4.5f : (width20 >= 2) ? 2.077f : 1.0f;
+        return (he ? heMbps[mcs] : htMbps[mcs]) * widthFactor;
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "InfoElements.h"
+
+// Hand-over from the promiscuous callback (Wi-Fi task) to the loop: a single-producer/single-consumer
+// ring of heard beacons, plus counters of the frames and airtime seen while connected. The loop
+// publishes the home channel, since the received-frame metadata does not carry a usable one.
+// The callback only calls noteFrame()/push(); the loop drains with pop() and takeBusyUs().
+class BeaconHarvester {
+public:
+    static constexpr size_t Capacity = 32; // power of two
+
+    struct Sample {
+        uint64_t bssidKey;
+        uint32_t timeMs;
+        int8_t rssi;
+        uint8_t channel;
+        ApCapabilities caps;
+    };
+
+    // Producer side
+    bool push(const Sample& sample) {
+        const uint32_t head = headIndex.load(std::memory_order_relaxed);
+        if (head - tailIndex.load(std::memory_order_acquire) >= Capacity) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ring[head & (Capacity - 1)] = sample;
+        headIndex.store(head + 1, std::memory_order_release);
+        beaconCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    void noteFrame(uint32_t airtimeUs) {
+        frameCount.fetch_add(1, std::memory_order_relaxed);
+        if (homeChannel.load(std::memory_order_relaxed) != 0) {
+            busyUsSum.fetch_add(airtimeUs, std::memory_order_relaxed);
+        }
+    }
+    // Channel the radio stays on between scans, 0 while not connected.
+    uint8_t currentHomeChannel() const {
+        return homeChannel.load(std::memory_order_relaxed);
+    }
+
+    // Consumer side
+    bool pop(Sample& out) {
+        const uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail == headIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = ring[tail & (Capacity - 1)];
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    // Airtime of the frames heard while connected since the last call. Windows that overlap a scan
+    // include off-channel frames; the loop discards those.
+    uint32_t takeBusyUs() {
+        return busyUsSum.exchange(0, std::memory_order_relaxed);
+    }
+    void setHomeChannel(uint8_t channel) {
+        homeChannel.store(channel, std::memory_order_relaxed);
+    }
+
+    uint32_t frames() const { return frameCount.load(std::memory_order_relaxed); }
+    uint32_t beacons() const { return beaconCount.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    // Rough on-air time of a frame: preamble plus payload bits at the PHY rate (SIFS/ACK not included).
+    static uint32_t estimateAirtimeUs(size_t lenBytes, uint32_t rateKbps, bool htPreamble) {
+        if (rateKbps == 0) {
+            rateKbps = 6000; // lowest 5 GHz OFDM rate
+        }
+        const uint32_t preambleUs = htPreamble ? 36 : 20;
+        return preambleUs + (uint32_t)(((uint64_t)lenBytes * 8000 + rateKbps - 1) / rateKbps);
+    }
+
+private:
+    Sample ring[Capacity];
+    std::atomic<uint32_t> headIndex{0};
+    std::atomic<uint32_t> tailIndex{0};
+    std::atomic<uint32_t> frameCount{0};
+    std::atomic<uint32_t> beaconCount{0};
+    std::atomic<uint32_t> droppedCount{0};
+    std::atomic<uint32_t> busyUsSum{0};
+    std::atomic<uint8_t> homeChannel{0};
+};
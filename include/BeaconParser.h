@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "InfoElements.h"
+
+// Parser for the 802.11 beacon and probe response frames handed to the promiscuous callback.
+// Works on the raw frame (MAC header, fixed fields, information elements) without allocating,
+// so it can run in the Wi-Fi task.
+struct BeaconInfo {
+    uint8_t bssid[6];
+    char ssid[33];            // NUL-terminated; empty for hidden networks
+    uint8_t channel;          // from the DS Parameter Set or HT Operation element, 0 if both are absent
+    uint16_t beaconIntervalTu;
+    bool probeResponse;       // false = beacon
+    ApCapabilities caps;
+};
+
+class BeaconParser {
+public:
+    static constexpr size_t HeaderLen = 24;      // frame control .. sequence control
+    static constexpr size_t FixedFieldsLen = 12; // timestamp, beacon interval, capability info
+    static constexpr uint8_t SubtypeProbeResponse = 5;
+    static constexpr uint8_t SubtypeBeacon = 8;
+
+    // True if frame (len bytes, FCS excluded) is a well-formed beacon or probe response.
+    static bool parse(const uint8_t* frame, size_t len, BeaconInfo& out) {
+        if (frame == nullptr || len < HeaderLen + FixedFieldsLen) {
+            return false;
+        }
+        const uint8_t type = (frame[0] >> 2) & 0x03;
+        const uint8_t subtype = (frame[0] >> 4) & 0x0F;
+        if (type != 0 || (subtype != SubtypeBeacon && subtype != SubtypeProbeResponse)) {
+            return false;
+        }
+        memcpy(out.bssid, frame + 16, 6); // address 3
+        out.ssid[0] = '\0';
+        out.channel = 0;
+        out.beaconIntervalTu = (uint16_t)(frame[HeaderLen + 8] | (frame[HeaderLen + 9] << 8));
+        out.probeResponse = subtype == SubtypeProbeResponse;
+
+        out.caps = ApCapabilities{};
+        out.caps.flags = ApCapabilities::FlagFromBeacon;
+        bool valid = true;
+        const bool complete = InfoElements::forEach(frame + HeaderLen + FixedFieldsLen, len - HeaderLen - FixedFieldsLen,
+            [&out, &valid](uint8_t id, const uint8_t* body, uint8_t bodyLen) {
+                if (id == InfoElements::IeSsid) {
+                    if (bodyLen > 32) {
+                        valid = false;
+                        return;
+                    }
+                    memcpy(out.ssid, body, bodyLen);
+                    out.ssid[bodyLen] = '\0';
+                } else if (id == InfoElements::IeDsParameterSet && bodyLen >= 1) {
+                    out.channel = body[0];
+                } else {
+                    if (id == InfoElements::IeHtOperation && bodyLen >= 1 && out.channel == 0) {
+                        out.channel = body[0]; // primary channel; 5 GHz beacons often omit the DS element
+                    }
+                    InfoElements::apply(id, body, bodyLen, out.caps);
+                }
+            });
+        return complete && valid;
+    }
+};
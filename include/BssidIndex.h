@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Packs a 6-byte BSSID (MAC address) into the low 48 bits of an integer key.
+inline uint64_t bssidToKey(const uint8_t bssid[6]) {
+    return ((uint64_t)bssid[0] << 40) | ((uint64_t)bssid[1] << 32) | ((uint64_t)bssid[2] << 24) |
+           ((uint64_t)bssid[3] << 16) | ((uint64_t)bssid[4] << 8) | (uint64_t)bssid[5];
+}
+
+// Unpacks a key made by bssidToKey() back into 6 bytes.
+inline void bssidFromKey(uint64_t key, uint8_t bssid[6]) {
+    for (int i = 5; i >= 0; i--) {
+        bssid[i] = (uint8_t)(key & 0xFF);
+        key >>= 8;
+    }
+}
+
+// Formats a packed BSSID as "AA:BB:CC:DD:EE:FF" (same format as WiFi.BSSIDstr()). out must hold 18 chars.
+inline void bssidKeyToChars(uint64_t key, char out[18]) {
+    uint8_t b[6];
+    bssidFromKey(key, b);
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X", b[0], b[1], b[2], b[3], b[4], b[5]);
+}
+
+// Key of the physical radio a BSSID probably belongs to. APs that serve several SSIDs (virtual APs)
+// usually derive the extra BSSIDs from one base MAC by changing the low nibble of the last byte
+// and/or setting the locally administered bit, e.g. 70:90:41:12:8D:51 and 70:90:41:12:8D:54.
+// Those bits are masked out and the channel is added, so BSSIDs on different channels never match.
+inline uint64_t radioKeyOf(uint64_t bssidKey, uint8_t channel) {
+    const uint64_t mask = ~(0x0FULL | (0x02ULL << 40));
+    return (bssidKey & mask) | ((uint64_t)channel << 48);
+}
+
+// Formatted BSSID in a stack buffer, e.g. for debug output without String allocations.
+struct BssidStr {
+    char s[18];
+    explicit BssidStr(uint64_t key) {
+        bssidKeyToChars(key, s);
+    }
+    const char* c_str() const {
+        return s;
+    }
+};
+
+// Open-addressing (linear probing) hash index from a packed BSSID to a position in a list.
+// Positions are plain indices, so the owner must rebuild the index after reordering or erasing entries.
+class BssidIndex {
+public:
+    static constexpr int32_t NotFound = -1;
+
+    void clear() {
+        for (auto& slot : slots) {
+            slot.pos = NotFound;
+        }
+        count = 0;
+    }
+
+    // Makes room for n entries without rehashing (load factor stays <= 0.5).
+    void reserve(size_t n) {
+        size_t cap = 16;
+        while (cap < n * 2) {
+            cap <<= 1;
+        }
+        if (cap > slots.size()) {
+            rehash(cap);
+        }
+    }
+
+    // Inserts key, or updates its position if already present.
+    void insert(uint64_t key, int32_t pos) {
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+        const size_t mask = slots.size() - 1;
+        size_t i = hash(key) & mask;
+        while (slots[i].pos != NotFound) {
+            if (slots[i].key == key) {
+                slots[i].pos = pos;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i].key = key;
+        slots[i].pos = pos;
+        count++;
+    }
+
+    // Returns the position stored for key, or NotFound.
+    int32_t find(uint64_t key) const {
+        if (slots.empty()) {
+            return NotFound;
+        }
+        const size_t mask = slots.size() - 1;
+        size_t i = hash(key) & mask;
+        while (slots[i].pos != NotFound) {
+            if (slots[i].key == key) {
+                return slots[i].pos;
+            }
+            i = (i + 1) & mask;
+        }
+        return NotFound;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int32_t pos;
+    };
+
+    std::vector<Slot> slots; // size is always zero or a power of two
+    size_t count = 0;
+
+    static uint32_t hash(uint64_t key) {
+        // 64-bit finalizer (MurmurHash3 fmix64); spreads OUI-heavy keys across all slots
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (uint32_t)key;
+    }
+
+    void rehash(size_t newCap) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(newCap, Slot{0, NotFound});
+        count = 0;
+        for (const auto& slot : old) {
+            if (slot.pos != NotFound) {
+                insert(slot.key, slot.pos);
+            }
+        }
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Learned dwell time per channel for single-channel rescans, replacing the fixed DFS/non-DFS scan times.
+// A scan result carries no per-beacon timestamps, so a hit only proves the AP answers within the dwell used.
+// The dwell is therefore probed downwards after a run of hits, and grown again whenever a dwell came back
+// empty although the AP was in fact present (a "false empty", detected by the owner). Bounded by [minMs, maxMs].
+class ChannelDwell {
+public:
+    static constexpr size_t MaxChannels = 32; // more than the 28 channels of the 5 GHz band
+    static constexpr uint8_t ShrinkAfterHits = 8; // consecutive hits before the dwell is shortened by 1/8
+
+    struct Stats {
+        uint8_t channel = 0;      // 0 = unused slot
+        uint16_t dwellMs = 0;     // current learned dwell
+        uint8_t hitStreak = 0;    // consecutive hits since the dwell last changed
+        uint16_t hitDwellMs = 0;  // running mean of the dwells that found the AP (upper bound of the time to hear it)
+        uint32_t hits = 0;        // dwells that found the expected AP(s)
+        uint32_t empties = 0;     // dwells that found none of the expected APs
+        uint32_t falseEmpties = 0; // empty dwells while the AP was present
+    };
+
+    void setBounds(uint16_t minMs, uint16_t maxMs) {
+        boundMinMs = minMs;
+        boundMaxMs = maxMs;
+        for (size_t i = 0; i < used; i++) {
+            slots[i].dwellMs = clamp(slots[i].dwellMs);
+        }
+    }
+
+    // Forgets everything learned, e.g. after the configured default scan times changed.
+    void reset() {
+        used = 0;
+    }
+
+    // Dwell to use on channel; defaultMs (the configured scan time) until something was learned.
+    uint16_t dwellFor(uint8_t channel, uint16_t defaultMs) const {
+        const Stats* s = find(channel);
+        return (s != nullptr && s->dwellMs != 0) ? s->dwellMs : clamp(defaultMs);
+    }
+
+    void recordHit(uint8_t channel, uint16_t usedMs) {
+        Stats* s = slotFor(channel, usedMs);
+        if (s == nullptr) {
+            return;
+        }
+        s->hits++;
+        s->hitDwellMs = (s->hitDwellMs == 0) ? usedMs : (uint16_t)(s->hitDwellMs + ((int)usedMs - (int)s->hitDwellMs) / 4);
+        if (++s->hitStreak >= ShrinkAfterHits) {
+            s->dwellMs = clamp((uint16_t)(s->dwellMs - s->dwellMs / 8));
+            s->hitStreak = 0;
+        }
+    }
+
+    // An empty dwell; may also mean the AP is really gone, so this alone does not change the dwell.
+    void recordEmpty(uint8_t channel, uint16_t usedMs) {
+        Stats* s = slotFor(channel, usedMs);
+        if (s == nullptr) {
+            return;
+        }
+        s->empties++;
+        s->hitStreak = 0;
+    }
+
+    // An earlier empty dwell turned out to be wrong: grow the dwell by half.
+    void recordFalseEmpty(uint8_t channel, uint16_t usedMs) {
+        Stats* s = slotFor(channel, usedMs);
+        if (s == nullptr) {
+            return;
+        }
+        s->falseEmpties++;
+        s->hitStreak = 0;
+        s->dwellMs = clamp((uint16_t)(s->dwellMs + s->dwellMs / 2 + 1));
+    }
+
+    size_t size() const {
+        return used;
+    }
+    const Stats& operator[](size_t i) const {
+        return slots[i];
+    }
+
+private:
+    Stats slots[MaxChannels];
+    size_t used = 0;
+    uint16_t boundMinMs = 10;
+    uint16_t boundMaxMs = 1000;
+
+    uint16_t clamp(uint16_t ms) const {
+        return ms < boundMinMs ? boundMinMs : (ms > boundMaxMs ? boundMaxMs : ms);
+    }
+
+    const Stats* find(uint8_t channel) const {
+        for (size_t i = 0; i < used; i++) {
+            if (slots[i].channel == channel) {
+                return &slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Existing slot of channel, or a new one starting at initialMs; nullptr if the table is full.
+    Stats* slotFor(uint8_t channel, uint16_t initialMs) {
+        if (channel == 0) {
+            return nullptr;
+        }
+        Stats* s = const_cast<Stats*>(find(channel));
+        if (s == nullptr && used < MaxChannels) {
+            s = &slots[used++];
+            *s = Stats{};
+            s->channel = channel;
+            s->dwellMs = clamp(initialMs);
+        }
+        return s;
+    }
+};
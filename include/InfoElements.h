@@ -0,0 +1,229 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Capabilities of an AP that a roam policy can weigh, packed into 8 bytes for the AP table.
+// Filled from scan records (PHY modes, width, security) and from heard beacons, which also
+// carry BSS Load and the PMF bits.
+struct ApCapabilities {
+    // phy
+    static constexpr uint8_t PhyHt = 0x01;  // 802.11n
+    static constexpr uint8_t PhyVht = 0x02; // 802.11ac
+    static constexpr uint8_t PhyHe = 0x04;  // 802.11ax
+    static constexpr uint8_t PhyEht = 0x08; // 802.11be
+    // akms
+    static constexpr uint8_t AkmEap = 0x01;
+    static constexpr uint8_t AkmPsk = 0x02;
+    static constexpr uint8_t AkmSae = 0x04;
+    static constexpr uint8_t AkmOwe = 0x08;
+    static constexpr uint8_t AkmFt = 0x10;     // any fast-transition AKM
+    static constexpr uint8_t AkmSuiteB = 0x20;
+    // ciphers (pairwise)
+    static constexpr uint8_t CipherTkip = 0x01;
+    static constexpr uint8_t CipherCcmp = 0x02;
+    static constexpr uint8_t CipherGcmp = 0x04;
+    // flags
+    static constexpr uint8_t FlagBssLoad = 0x01;     // bssLoadUtil/bssLoadStations are valid
+    static constexpr uint8_t FlagPmfCapable = 0x02;
+    static constexpr uint8_t FlagPmfRequired = 0x04;
+    static constexpr uint8_t FlagFromBeacon = 0x08;  // PMF bits are known
+
+    uint8_t phy;
+    uint8_t widthMhz20;   // channel width in units of 20 MHz (1, 2, 4, 8), 0 = unknown
+    uint8_t akms;
+    uint8_t ciphers;
+    uint8_t flags;
+    uint8_t bssLoadUtil;  // channel utilisation from BSS Load, 255 = 100 %
+    uint16_t bssLoadStations;
+
+    uint16_t widthMhz() const { return (uint16_t)widthMhz20 * 20; }
+    float bssLoadPercent() const { return bssLoadUtil * 100.0f / 255.0f; }
+    const char* phyName() const {
+        if (phy & PhyEht) return "be";
+        if (phy & PhyHe) return "ax";
+        if (phy & PhyVht) return "ac";
+        if (phy & PhyHt) return "n";
+        return "a";
+    }
+    // AKMs as e.g. "PSK/SAE/FT" into buf (size >= 1); empty for open networks.
+    const char* akmNames(char* buf, size_t size) const {
+        static const char* const names[6] = {"EAP", "PSK", "SAE", "OWE", "FT", "SuiteB"};
+        size_t used = 0;
+        for (uint8_t bit = 0; bit < 6; bit++) {
+            if (!(akms & (1u << bit))) {
+                continue;
+            }
+            if (used != 0 && used + 1 < size) {
+                buf[used++] = '/';
+            }
+            for (const char* c = names[bit]; *c != '\0' && used + 1 < size; c++) {
+                buf[used++] = *c;
+            }
+        }
+        buf[used] = '\0';
+        return buf;
+    }
+};
+
+// Bounded, allocation-free walker over an 802.11 information element list (the part of a beacon or
+// probe response after the fixed fields). Only reads inside [ies, ies + len).
+class InfoElements {
+public:
+    static constexpr size_t MaxElements = 64; // bound on the walk; real beacons carry 10 to 30
+    static constexpr uint8_t IeSsid = 0;
+    static constexpr uint8_t IeDsParameterSet = 3;
+    static constexpr uint8_t IeBssLoad = 11;
+    static constexpr uint8_t IeHtCapabilities = 45;
+    static constexpr uint8_t IeRsn = 48;
+    static constexpr uint8_t IeHtOperation = 61;
+    static constexpr uint8_t IeVhtCapabilities = 191;
+    static constexpr uint8_t IeVhtOperation = 192;
+    static constexpr uint8_t IeExtension = 255;
+    static constexpr uint8_t ExtHeCapabilities = 35;
+    static constexpr uint8_t ExtEhtCapabilities = 108;
+
+    // Calls visit(id, body, bodyLen) for each element, in order. False if the list is truncated
+    // or longer than MaxElements; the elements before that point have been visited.
+    template <typename Visitor>
+    static bool forEach(const uint8_t* ies, size_t len, Visitor&& visit) {
+        size_t pos = 0;
+        for (size_t n = 0; pos + 2 <= len; n++) {
+            if (n == MaxElements) {
+                return false;
+            }
+            const uint8_t id = ies[pos];
+            const uint8_t bodyLen = ies[pos + 1];
+            if (pos + 2 + bodyLen > len) {
+                return false;
+            }
+            visit(id, ies + pos + 2, bodyLen);
+            pos += 2 + (size_t)bodyLen;
+        }
+        return pos == len;
+    }
+
+    // Folds one element into caps; unrelated elements are ignored.
+    static void apply(uint8_t id, const uint8_t* body, uint8_t len, ApCapabilities& caps) {
+        switch (id) {
+            case IeBssLoad:
+                if (len >= 5) {
+                    caps.bssLoadStations = (uint16_t)(body[0] | (body[1] << 8));
+                    caps.bssLoadUtil = body[2];
+                    caps.flags |= ApCapabilities::FlagBssLoad;
+                }
+                break;
+            case IeHtCapabilities:
+                caps.phy |= ApCapabilities::PhyHt;
+                break;
+            case IeHtOperation:
+                // Secondary channel offset set and any width allowed: 40 MHz
+                widen(caps, (len >= 2 && (body[1] & 0x03) != 0 && (body[1] & 0x04) != 0) ? 2 : 1);
+                break;
+            case IeVhtCapabilities:
+                caps.phy |= ApCapabilities::PhyVht;
+                break;
+            case IeVhtOperation:
+                if (len >= 3 && body[0] == 1) {
+                    // 80 MHz; 160 MHz when the second centre frequency is 8 channels from the first
+                    const int ccfs0 = body[1];
+                    const int ccfs1 = body[2];
+                    widen(caps, (ccfs1 != 0 && (ccfs1 - ccfs0 == 8 || ccfs0 - ccfs1 == 8)) ? 8 : 4);
+                } else if (len >= 1 && (body[0] == 2 || body[0] == 3)) {
+                    widen(caps, 8); // deprecated 160 and 80+80 encodings
+                }
+                break;
+            case IeExtension:
+                if (len >= 1 && body[0] == ExtHeCapabilities) {
+                    caps.phy |= ApCapabilities::PhyHe;
+                } else if (len >= 1 && body[0] == ExtEhtCapabilities) {
+                    caps.phy |= ApCapabilities::PhyEht;
+                }
+                break;
+            case IeRsn:
+                applyRsn(body, len, caps);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Capabilities advertised by an element list. False if the list is malformed (caps then holds
+    // what was read before the fault).
+    static bool parse(const uint8_t* ies, size_t len, ApCapabilities& caps) {
+        caps = ApCapabilities{};
+        caps.flags = ApCapabilities::FlagFromBeacon;
+        return forEach(ies, len, [&caps](uint8_t id, const uint8_t* body, uint8_t bodyLen) {
+            apply(id, body, bodyLen, caps);
+        });
+    }
+
+private:
+    static void widen(ApCapabilities& caps, uint8_t widthMhz20) {
+        if (widthMhz20 > caps.widthMhz20) {
+            caps.widthMhz20 = widthMhz20;
+        }
+    }
+
+    static bool isIeeeSuite(const uint8_t* suite) {
+        return suite[0] == 0x00 && suite[1] == 0x0F && suite[2] == 0xAC;
+    }
+
+    // RSN element: version, group cipher, pairwise ciphers, AKMs, RSN capabilities. Every field after
+    // the version is optional; reading stops at the first list or field that does not fit.
+    static void applyRsn(const uint8_t* body, uint8_t len, ApCapabilities& caps) {
+        size_t pos = 2 + 4; // version, group data cipher suite
+        if (pos + 2 > len) {
+            return;
+        }
+        size_t count = (size_t)(body[pos] | (body[pos + 1] << 8));
+        pos += 2;
+        if (pos + count * 4 > len) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++, pos += 4) {
+            if (!isIeeeSuite(body + pos)) {
+                continue;
+            }
+            switch (body[pos + 3]) {
+                case 2: caps.ciphers |= ApCapabilities::CipherTkip; break;
+                case 4: case 10: caps.ciphers |= ApCapabilities::CipherCcmp; break;
+                case 8: case 9: caps.ciphers |= ApCapabilities::CipherGcmp; break;
+                default: break;
+            }
+        }
+        if (pos + 2 > len) {
+            return;
+        }
+        count = (size_t)(body[pos] | (body[pos + 1] << 8));
+        pos += 2;
+        if (pos + count * 4 > len) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++, pos += 4) {
+            if (!isIeeeSuite(body + pos)) {
+                continue;
+            }
+            switch (body[pos + 3]) {
+                case 1: case 5: caps.akms |= ApCapabilities::AkmEap; break;
+                case 2: case 6: caps.akms |= ApCapabilities::AkmPsk; break;
+                case 3: caps.akms |= ApCapabilities::AkmEap | ApCapabilities::AkmFt; break;
+                case 4: caps.akms |= ApCapabilities::AkmPsk | ApCapabilities::AkmFt; break;
+                case 8: case 24: caps.akms |= ApCapabilities::AkmSae; break;
+                case 9: case 25: caps.akms |= ApCapabilities::AkmSae | ApCapabilities::AkmFt; break;
+                case 11: case 12: caps.akms |= ApCapabilities::AkmEap | ApCapabilities::AkmSuiteB; break;
+                case 18: caps.akms |= ApCapabilities::AkmOwe; break;
+                default: break;
+            }
+        }
+        if (pos + 2 > len) {
+            return;
+        }
+        const uint16_t rsnCaps = (uint16_t)(body[pos] | (body[pos + 1] << 8));
+        if (rsnCaps & 0x0040) {
+            caps.flags |= ApCapabilities::FlagPmfRequired;
+        }
+        if (rsnCaps & 0x0080) {
+            caps.flags |= ApCapabilities::FlagPmfCapable;
+        }
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Immutable hashed lookup of the known SSIDs, built once in RoamingWiFiManager::init().
+// find() returns the index of the first credential with that SSID, or -1.
+// Stores pointers to the SSID strings passed to build(), so those must not change afterwards.
+class KnownSsidSet {
+public:
+    // 32-bit FNV-1a hash of a NUL-terminated SSID
+    static uint32_t hashSsid(const char* ssid) {
+        uint32_t h = 2166136261u;
+        for (const uint8_t* p = (const uint8_t*)ssid; *p; p++) {
+            h ^= *p;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // ssids[i] is the SSID of credential i
+    void build(const std::vector<const char*>& ssids) {
+        names = ssids;
+        size_t cap = 8;
+        while (cap < ssids.size() * 2) {
+            cap <<= 1;
+        }
+        slots.assign(cap, Slot{0, -1});
+        for (size_t i = 0; i < ssids.size(); i++) {
+            if (ssids[i] == nullptr || ssids[i][0] == '\0') {
+                continue;
+            }
+            const uint32_t h = hashSsid(ssids[i]);
+            size_t pos = h & (cap - 1);
+            bool duplicate = false;
+            while (slots[pos].index >= 0) {
+                if (slots[pos].hash == h && strcmp(names[(size_t)slots[pos].index], ssids[i]) == 0) {
+                    duplicate = true; // first credential with this SSID wins
+                    break;
+                }
+                pos = (pos + 1) & (cap - 1);
+            }
+            if (!duplicate) {
+                slots[pos].hash = h;
+                slots[pos].index = (int16_t)i;
+            }
+        }
+    }
+
+    int find(const char* ssid) const {
+        if (slots.empty() || ssid == nullptr || ssid[0] == '\0') {
+            return -1;
+        }
+        const uint32_t h = hashSsid(ssid);
+        const size_t mask = slots.size() - 1;
+        size_t pos = h & mask;
+        while (slots[pos].index >= 0) {
+            if (slots[pos].hash == h && strcmp(names[(size_t)slots[pos].index], ssid) == 0) {
+                return slots[pos].index;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return -1;
+    }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        int16_t index; // -1 = empty slot
+    };
+
+    std::vector<Slot> slots; // size is zero or a power of two
+    std::vector<const char*> names;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+// Number of adjacent pairs of v that are out of order under less; 0 means v is sorted.
+template <typename T, typename Less>
+size_t countOutOfOrder(const std::vector<T>& v, Less less) {
+    size_t outOfOrder = 0;
+    for (size_t i = 1; i < v.size(); i++) {
+        if (less(v[i], v[i - 1])) {
+            outOfOrder++;
+        }
+    }
+    return outOfOrder;
+}
+
+// Sorts v in place, given its countOutOfOrder(). A nearly sorted vector (at most maxDirty pairs out of
+// order, e.g. after a few RSSI updates) takes an insertion sort in O(n + moves), anything else std::sort.
+template <typename T, typename Less>
+void sortNearlySorted(std::vector<T>& v, Less less, size_t outOfOrder, size_t maxDirty) {
+    if (outOfOrder == 0) {
+        return;
+    }
+    if (outOfOrder > maxDirty) {
+        std::sort(v.begin(), v.end(), less);
+        return;
+    }
+    for (size_t i = 1; i < v.size(); i++) {
+        if (!less(v[i], v[i - 1])) {
+            continue;
+        }
+        const T moving = v[i];
+        size_t j = i;
+        while (j > 0 && less(moving, v[j - 1])) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = moving;
+    }
+}
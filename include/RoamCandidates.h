@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Best scored detected BSSIDs per known SSID (credential), kept up to date as scan results are
+// written to the AP table, so roam and reconnect decisions don't have to walk the whole table.
+// Each credential keeps its top K entries sorted by score (see ApScore.h), best first. When an entry drops
+// out of a full list, a weaker BSSID that was not tracked may now belong in it, so that credential
+// is marked dirty and the owner refills it from the table (see needsRebuild()).
+class RoamCandidates {
+public:
+    static constexpr size_t K = 4;
+
+    struct Candidate {
+        uint64_t bssidKey;
+        uint64_t radioKey; // see radioKeyOf()
+        int8_t rssi;
+        int16_t score;
+    };
+
+    // One (empty, dirty) list per credential.
+    void reset(size_t credentialCount) {
+        lists.assign(credentialCount, List{});
+        for (auto& list : lists) {
+            list.dirty = true;
+        }
+        anyDirty = credentialCount > 0;
+    }
+
+    // Records the current state of one AP table entry. eligible=false removes it.
+    void update(int credential, uint64_t bssidKey, uint64_t radioKey, int8_t rssi, int16_t score, bool eligible) {
+        if (credential < 0 || (size_t)credential >= lists.size()) {
+            return;
+        }
+        List& list = lists[(size_t)credential];
+        const bool wasFull = list.count == K;
+        bool removed = false;
+        int16_t oldScore = 0;
+        for (uint8_t i = 0; i < list.count; i++) {
+            if (list.items[i].bssidKey == bssidKey) {
+                oldScore = list.items[i].score;
+                for (uint8_t j = i; j + 1 < list.count; j++) {
+                    list.items[j] = list.items[j + 1];
+                }
+                list.count--;
+                removed = true;
+                break;
+            }
+        }
+        if (eligible) {
+            insertSorted(list, Candidate{bssidKey, radioKey, rssi, score});
+        }
+        // If a tracked entry left a full list, or scored lower while ranked last,
+        // an untracked BSSID may now belong in the top K.
+        if (removed && wasFull) {
+            const bool leftList = list.count < K;
+            const bool weakerLast = list.items[K - 1].bssidKey == bssidKey && score < oldScore;
+            if (leftList || weakerLast) {
+                list.dirty = true;
+                anyDirty = true;
+            }
+        }
+    }
+
+    // Marks every list for a refill, e.g. after entries were erased or bulk-modified.
+    void markAllDirty() {
+        for (auto& list : lists) {
+            list.dirty = true;
+        }
+        anyDirty = !lists.empty();
+    }
+
+    bool needsRebuild() const {
+        return anyDirty;
+    }
+    bool isDirty(int credential) const {
+        return credential >= 0 && (size_t)credential < lists.size() && lists[(size_t)credential].dirty;
+    }
+    // Empties the dirty lists; the owner then update()s every eligible entry of those credentials and calls endRebuild().
+    void beginRebuild() {
+        for (auto& list : lists) {
+            if (list.dirty) {
+                list.count = 0;
+            }
+        }
+    }
+    void endRebuild() {
+        for (auto& list : lists) {
+            list.dirty = false;
+        }
+        anyDirty = false;
+    }
+
+    // Best scored candidate of a credential that is not on radio excludeRadioKey, or nullptr.
+    // Radios rather than BSSIDs are excluded, so roaming never picks another virtual AP of the current radio.
+    const Candidate* best(int credential, uint64_t excludeRadioKey) const {
+        if (credential < 0 || (size_t)credential >= lists.size()) {
+            return nullptr;
+        }
+        const List& list = lists[(size_t)credential];
+        for (uint8_t i = 0; i < list.count; i++) {
+            if (list.items[i].radioKey != excludeRadioKey) {
+                return &list.items[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Best scored candidate over all credentials that is not on radio excludeRadioKey, or nullptr.
+    const Candidate* bestOverall(uint64_t excludeRadioKey) const {
+        const Candidate* result = nullptr;
+        for (size_t c = 0; c < lists.size(); c++) {
+            const Candidate* cand = best((int)c, excludeRadioKey);
+            if (cand != nullptr && (result == nullptr || cand->score > result->score)) {
+                result = cand;
+            }
+        }
+        return result;
+    }
+
+private:
+    struct List {
+        Candidate items[K];
+        uint8_t count = 0;
+        bool dirty = false;
+    };
+
+    std::vector<List> lists; // indexed by credential
+    bool anyDirty = false;
+
+    static void insertSorted(List& list, const Candidate& cand) {
+        uint8_t pos = list.count;
+        while (pos > 0 && list.items[pos - 1].score < cand.score) {
+            pos--;
+        }
+        if (pos >= K) {
+            return; // weaker than all K tracked entries
+        }
+        const uint8_t last = (list.count < K) ? list.count : (uint8_t)(K - 1);
+        for (uint8_t j = last; j > pos; j--) {
+            list.items[j] = list.items[j - 1];
+        }
+        list.items[pos] = cand;
+        if (list.count < K) {
+            list.count++;
+        }
+    }
+};
@@ -5,6 +5,17 @@
 #include <ArduinoJson.h>
 #include <Preferences.h>
 #include <vector>
+#include "BssidIndex.h"
+#include "KnownSsidSet.h"
+#include "RoamCandidates.h"
+#include "ChannelDwell.h"
+#include "ScanJobQueue.h"
+#include "AirtimeBudget.h"
+#include "BeaconParser.h"
+#include "BeaconHarvester.h"
+#include "ApScore.h"
+#include "RssiFilter.h"
+#include "NearlySorted.h"
 
 class NetworkCredentials {
 public:
@@ -12,19 +23,57 @@ public:
     String password;
 };
 
+// Compact, trivially copyable AP table entry (no heap allocations), so the whole
+// table lives in one contiguous block. Construct with value-initialization: ScannedNetwork net{};
 class ScannedNetwork {
 public:
-    String ssid;
-    int32_t rssi;
-    String bssid;
+    static constexpr uint8_t AuthModeUnknown = WIFI_AUTH_MAX;
+
+    char ssid[33];      // NUL-terminated, same size as wifi_ap_record_t::ssid
+    uint8_t bssid[6];
+    int8_t rssi;        // latest sample
     uint8_t channel;
-    String encryption;
-    bool scanned;
-    bool detected;
-    bool known;
+    uint8_t authMode;   // wifi_auth_mode_t, or AuthModeUnknown
+    uint8_t scanned : 1;
+    uint8_t detected : 1;
+    uint8_t sortRank : 2; // group used by RoamingWiFiManager::sortNetworks(), 0 sorts first
+    uint8_t evictPending : 1; // set only inside RoamingWiFiManager::enforceApTableLimits()
+    uint8_t sweepRefreshed : 1; // refreshed through another BSSID of the same radio during the current rescan sweep
+    uint8_t missPending : 1; // a targeted dwell came back empty while this entry was detected; cleared when heard again
+    uint8_t dwellBoost : 1;  // last dwell missed this BSSID although it was present: use a longer dwell next time
+    uint16_t credentialId; // 1-based index into knownNetworks, resolved when the SSID changes; 0 = unknown SSID
+    uint32_t lastSeenMs;   // millis() when this BSSID was last detected
+    uint32_t nextRescanMs; // millis() deadline of the next targeted rescan (priority scheduler), 0 = due
+    uint8_t rssiVolatility; // running mean of |RSSI change| between detections, in 0.25 dB units
+    uint8_t falseEmpties;   // dwells that missed this BSSID although it was present (saturating)
+    ApCapabilities caps;    // PHY, width, security, BSS Load; see updateCapabilitiesFromRecord()
+    RssiFilter rssiFilter;  // smoothed RSSI and trend, fed by RoamingWiFiManager::noteRssiSample()
 public:
-    bool isEmpty() {
-        return ssid.isEmpty();
+    bool isKnown() const {
+        return credentialId != 0;
+    }
+    int credentialIndex() const {
+        return (int)credentialId - 1;
+    }
+    bool isEmpty() const {
+        return ssid[0] == '\0';
+    }
+    uint64_t bssidKey() const {
+        return bssidToKey(bssid);
+    }
+    // Filtered RSSI that sorting, scoring and roaming use; the latest sample until the filter has one.
+    int8_t smoothedRssi() const {
+        return rssiFilter.empty() ? rssi : rssiFilter.rssi();
+    }
+    uint64_t radioKey() const {
+        return radioKeyOf(bssidKey(), channel);
+    }
+    BssidStr bssidStr() const {
+        return BssidStr(bssidKey());
+    }
+    const char* encryptionStr() const {
+        if (authMode == AuthModeUnknown) return "Unknown";
+        return (authMode == WIFI_AUTH_OPEN) ? "Open" : "Encrypted";
     }
 };
 
@@ -42,6 +91,9 @@ class RoamingWiFiManager {
         // By default the manager controls the LED. Disable it to control it yourself.
         static void setUseLEDIndicator(bool enable);
 
+        // Replaces the built-in AP scoring used to rank connect and roam candidates; nullptr restores it.
+        void setScoreFunction(ApScoreFunction fn);
+
         // Constructor. serverPort: port number for the web server (default 80).
         RoamingWiFiManager(int serverPort=80);
 
@@ -66,14 +118,87 @@ class RoamingWiFiManager {
             AutoFull,   // full scan, automatically triggered
             AutoRescanSingle, // rescan of a single network, automatically triggered
             AutoRescanTestChannel, // test scan of a single channel, automatically triggered
+            AutoRescanChannel, // rescan of all entries on one channel (channel-grouped sweep), automatically triggered
+            RoamVerify, // targeted scan of a roam candidate with a stale RSSI, before roaming to it
+            ReconnectFull, // full scan while disconnected with no known network in the AP table
+            FullScanChunk, // one channel of a chunked full scan (see FullScanMode::Chunked)
         };
+        static bool isSweepPurpose(ScanPurpose purpose); // part of a rescan sweep
 
         // converts ScanPurpose to string
         static String toString(ScanPurpose purpose);
 
+        // How a full scan runs while connected; a full scan while disconnected always runs as one burst.
+        enum class FullScanMode : uint8_t {
+            Burst,     // WiFi.scanNetworks() over all channels, the driver's default home-channel returns
+            HomeDwell, // as Burst, but the driver stays fullScanHomeDwellMs on the home channel between channels
+            Chunked,   // one single-channel job per channel, home for fullScanHomeDwellMs after every fullScanChunkChannels
+        };
+        static const char* toString(FullScanMode mode);
+        static bool parseFullScanMode(const char* name, FullScanMode& mode); // false if name is unknown
+
+        // Quality of the connected link, for RSSI-event driven scanning. Ordered from best to worst.
+        enum class LinkLevel : uint8_t {
+            Good, // above rssiRescanThresholdDbm: no background scans
+            Weak, // below rssiRescanThresholdDbm: rescan known candidates
+            Edge, // below rssiFullScanThresholdDbm: rescans plus frequent full scans, not held back by the airtime budget
+        };
+        static const char* toString(LinkLevel level);
+
+        // Current association, maintained by handleWiFiEvent() so the loop does not need WiFi.SSID()/BSSIDstr() Strings.
+        // The event task writes eventConnection under connectionMux; the loop works on its own copy, connection,
+        // refreshed by syncConnectionSnapshot(), so it never sees a half-written BSSID or SSID.
+        struct ConnectionSnapshot {
+            bool connected = false;       // between STA connected (112) and STA disconnected (113)
+            int16_t credentialIndex = -1; // index into knownNetworks, -1 if the SSID is not known
+            uint64_t bssidKey = 0;        // packed BSSID, 0 if not connected
+            uint8_t channel = 0;
+            int8_t rssi = 0;              // last sampled RSSI, see getConnectedRssi()
+            uint32_t rssiTimeMs = 0;      // when rssi was sampled, 0 = never
+            char ssid[33] = "";
+        };
+        static constexpr uint32_t ConnectionRssiMaxAgeMs = 250; // getConnectedRssi() re-samples the driver after this
+        // Connected-AP RSSI sampling (persisted): the driver's beacon RSSI of the serving AP, read without a scan every
+        // connectedRssiSampleMs and written to its AP table entry, which rescan sweeps then skip. 0 = off.
+        uint32_t connectedRssiSampleMs = 500;
+        static constexpr size_t ConnectedRssiTraceSize = 64;
+        struct RssiSample {
+            uint32_t timeMs;
+            int8_t rssi;
+        };
+        RssiSample connectedRssiTrace[ConnectedRssiTraceSize] = {}; // ring buffer of the latest samples
+        size_t connectedRssiTraceCount = 0; // samples since boot; the ring holds the last ConnectedRssiTraceSize
+        uint32_t connectedRssiSampleTimeMs = 0; // last sample written to the trace and the AP table
+        // Reads the driver and updates connection.rssi; record also writes the trace and the AP table entry,
+        // which only handleConnectedRssiSampling() does, so the table follows connectedRssiSampleMs.
+        void sampleConnectedRssi(bool record);
+        void handleConnectedRssiSampling(); // samples when connectedRssiSampleMs elapsed
+        // Passive beacon harvesting (persisted): in promiscuous mode, beacons and probe responses heard on the
+        // current channel refresh RSSI and lastSeen of their AP table entries (no new entries are added), and the
+        // airtime of all frames on the home channel gives an estimate of its utilisation.
+        bool beaconHarvest = false;
+        bool promiscuousActive = false;
+        BeaconHarvester harvester;
+        static RoamingWiFiManager* promiscuousOwner; // instance the promiscuous callback reports to
+        static constexpr uint32_t HarvestWindowMs = 1000; // utilisation measuring window
+        unsigned long harvestWindowStart = 0;
+        bool harvestWindowScanned = false; // a scan took the radio away in this window, so it is not measured
+        uint32_t harvestUpdateCount = 0; // table entries refreshed from beacons, since boot
+        float channelUtilisationPercent = -1.0f; // last measured window, -1 = unknown
+        float channelUtilisationAvgPercent = -1.0f; // running mean over about 8 windows
+        void applyBeaconHarvest(); // enters or leaves promiscuous mode per beaconHarvest
+        void handleBeaconHarvest(); // drains the harvested beacons into the AP table, updates the utilisation
+        static void handlePromiscuousPacket(void* buf, wifi_promiscuous_pkt_type_t type); // runs in the Wi-Fi task
+        static uint32_t rxRateKbps(const wifi_pkt_rx_ctrl_t& rx, bool& htPreamble); // PHY rate of a received frame
+        static uint32_t legacyRateKbps(unsigned rate); // DSSS/OFDM rate code
+        static uint32_t htRateKbps(unsigned mcs, unsigned streams, unsigned bandwidth); // HT/VHT; bandwidth 0..3 = 20..160 MHz
+        static constexpr float RescanRoamMarginWindowDb = 10.0f; // roam candidates within this of the roam threshold get rescanned sooner
+        static constexpr uint32_t DwellFalseEmptyWindowMs = 30000; // a missed BSSID heard again within this was never gone
+        static constexpr uint32_t RoamVerifyMaxAgeMs = 3000; // older roam candidates are rescanned before roaming to them
+        static constexpr uint32_t ScanAbortTimeoutMs = 1000; // give up waiting for a preempted scan to report completion
+
         // Static helper methods
         static bool parseBssid(const String& bssidStr, uint8_t bssid[6]);
-        static bool isDfsChannel(uint8_t channel); // Check if a channel is a DFS channel
 
         // Helper methods for splitting large functions
         void loadScanSettings();
@@ -82,13 +207,17 @@ class RoamingWiFiManager {
         void loadRoamSettings();
         void loadDebugLevel();
         void loadNetworkInfo();
+        void loadApTableSettings();
+        void loadTestChannelStats();
+        void saveTestChannelStats();
         
-        void handleAutoRoaming();
+        bool handleAutoRoaming(); // returns true if a roam was started
         bool handleStationDisconnect();
         bool handleConnectionRequests();
         bool handleAutoReconnect();
         bool handleAutomaticScanning();
         bool handleAsyncScanCompletion();
+        LinkLevel updateLinkLevel(); // consumes RSSI-low events, polls for recovery, re-arms the driver threshold
         
         void setupStatusEndpoints();
         void setupScanEndpoints();
@@ -98,7 +227,18 @@ class RoamingWiFiManager {
 
         // timestamps are all in ms
         std::vector<NetworkCredentials> knownNetworks; // known networks to try connecting to
+        KnownSsidSet knownSsids; // hashed SSID -> index into knownNetworks, built once in init()
+        RoamCandidates roamCandidates; // best scored detected BSSIDs per known SSID, fed by noteNetworkChanged()
+        bool roamScoringChanged = false; // set by the web handlers; refreshRoamCandidates() marks all lists dirty
         std::vector<ScannedNetwork> scannedNetworkList; // scanned networks from last scan
+        BssidIndex scannedNetworkIndex; // bssidKey -> position in scannedNetworkList; rebuilt whenever the list is reordered
+        ConnectionSnapshot connection; // the loop's copy of eventConnection, see syncConnectionSnapshot()
+        ConnectionSnapshot eventConnection; // written by handleWiFiEvent() only, under connectionMux
+        bool eventConnectionChanged = false; // under connectionMux
+        portMUX_TYPE connectionMux = portMUX_INITIALIZER_UNLOCKED;
+        void syncConnectionSnapshot(); // takes over eventConnection if an event changed it; start of loop()
+        ChannelDwell channelDwell; // learned per-channel dwell times (adaptiveDwell)
+        uint16_t lastScanDwellMs = 0; // scan time per channel of the current/last single-channel scan
         std::vector<String> _clientIpAddresses; // list of assigned IP addresses, to help finding the unknown client IP for a specific network
 
         String _adminUser;
@@ -134,23 +274,150 @@ class RoamingWiFiManager {
         // Scan time settings (persisted)
         uint32_t scanTimeNonDfsMs = 50; // max scan time per channel for non-DFS channels (ms)
         uint32_t scanTimeDfsMs = 200;    // max scan time per channel for DFS channels (ms)
+        // Adaptive dwell (persisted): single-channel rescans learn their scan time per channel, starting
+        // from the values above and staying within [dwellMinMs, dwellMaxMs]. See ChannelDwell.
+        bool adaptiveDwell = true;
+        uint32_t dwellMinMs = 20;
+        uint32_t dwellMaxMs = 400;
+
+        // AP table limits (persisted). The connected AP is never evicted.
+        uint32_t apTableCapacity = 128; // max entries in scannedNetworkList
+        float apTableMaxAgeSec = 600.0f; // undetected entries not seen for this long are dropped; 0 = no age limit
+        uint32_t apTableEvictedCapacityCount = 0; // entries dropped because the table was full, since boot
+        uint32_t apTableEvictedAgeCount = 0; // entries dropped because they were too old, since boot
+        // Ingestion policy for BSSIDs of unknown SSIDs (persisted). Known SSIDs are always kept.
+        uint32_t apUnknownTopK = 32; // keep at most this many unknown BSSIDs, strongest first
+        bool apDropUnknown = false; // if true, unknown SSIDs are not stored at all
+        uint32_t apTableEvictedPolicyCount = 0; // unknown entries dropped by the ingestion policy, since boot
+        uint32_t apIngestSkippedCount = 0; // scan records of unknown SSIDs not admitted to the table, since boot
 
         bool scanInProgress = false;
-        ScanPurpose scanPurpose = ScanPurpose::None;
+        ScanPurpose scanPurpose = ScanPurpose::None; // purpose of the running (or last) scan
+        // All scans go through this queue and are started by dispatchScanJobs(), most urgent first.
+        // A running Rescan/Discovery scan is aborted when a more urgent job waits, and queued again.
+        ScanJobQueue scanJobs;
+        ScanJob runningScanJob; // job of the running (or last) scan
+        bool scanAbortRequested = false; // the running scan is being preempted
+        unsigned long scanAbortTime = 0; // when the preemption was requested (ms)
+        uint32_t scanPreemptedCount = 0; // scans preempted since boot
+        ScanJobPriority autoRescanSweepJobPriority = ScanJobPriority::Rescan; // priority of the jobs of the current sweep
+        // Off-channel airtime budget (persisted): while connected, Rescan/Discovery jobs only start if they fit
+        // airtimeBudgetPercent of any airtimeWindowMs; urgent jobs are booked but never held back. 100% = unlimited.
+        float airtimeBudgetPercent = 10.0f;
+        uint32_t airtimeWindowMs = 1000;
+        AirtimeBudget airtime; // loop only; web handlers set airtimeConfigPending and read airtimeStats
+        bool airtimeConfigPending = false; // airtimeBudgetPercent/airtimeWindowMs changed, configure() in the loop
+        AirtimeBudget::Stats airtimeStats = {}; // published by handleAirtimeBudget() under airtimeStatsMux
+        portMUX_TYPE airtimeStatsMux = portMUX_INITIALIZER_UNLOCKED;
+        void handleAirtimeBudget(); // applies settings changes and publishes airtimeStats
+        bool scanOffChannel = false; // the running scan takes the radio off the home channel
+        bool airtimeDeferring = false; // the most urgent job is being held back by the budget
+        uint32_t lastFullScanDurationMs = 3000; // measured; the airtime estimate of the next full scan
+        // Full scans while connected (persisted): return to the home channel between scanned channels, so periodic
+        // full scans don't black out traffic for the whole sweep. Chunks are separate jobs, subject to the airtime budget.
+        FullScanMode fullScanConnectedMode = FullScanMode::Chunked;
+        uint32_t fullScanHomeDwellMs = 100; // time on the home channel between chunks; HomeDwell caps it at the driver's 150 ms
+        uint32_t fullScanChunkChannels = 2; // channels scanned back to back before returning home (Chunked)
+        // Progressive full scans (persisted): every full scan, also while disconnected, runs in chunks and merges
+        // each channel into the AP table as it arrives, so roaming and reconnecting can act before the sweep ends.
+        // Overrides fullScanConnectedMode; the home-channel pauses only apply while connected.
+        bool fullScanProgressive = true;
+        static constexpr uint32_t FullScanConnectHoldMs = 1000; // no chunk starts this soon after a connect attempt
+        // RSSI-event driven scanning (persisted): while connected, background scans follow the link level instead of
+        // the auto full-scan/rescan timers. The driver's RSSI-low event reports drops; recovery is polled while below Good.
+        bool rssiEventScanning = false;
+        int32_t rssiRescanThresholdDbm = -70;
+        int32_t rssiFullScanThresholdDbm = -80;
+        uint32_t rssiHysteresisDb = 5; // a level is left upwards only this far above its threshold
+        float rssiEdgeFullIntervalSec = 10.0f; // full scan interval at the cell edge
+        LinkLevel linkLevel = LinkLevel::Good;
+        uint64_t rssiArmedBssid = 0; // connection the level was evaluated for; 0 = evaluate again
+        bool rssiLowEventPending = false; // set by handleRssiLowEvent() under connectionMux
+        int32_t rssiLowEventRssi = 0;     // under connectionMux, with rssiLowEventPending
+        int32_t rssiLowLastRssi = 0;      // loop's copy of the last event's RSSI, for /wifi/status
+        uint32_t rssiLowEventCount = 0; // since boot
+        uint32_t linkLevelChangeCount = 0; // since boot
+        esp_event_handler_instance_t rssiLowEventHandler = nullptr;
+        LinkLevel linkLevelFor(int rssi) const; // level for rssi, with hysteresis relative to linkLevel
+        void armRssiThreshold(); // next driver event: the threshold below the current level
+        bool fullScanChunkActive = false; // a chunked full scan is in progress
+        ScanPurpose fullScanChunkPurpose = ScanPurpose::None; // full scan the chunks belong to
+        ScanJobPriority fullScanChunkPriority = ScanJobPriority::Discovery;
+        size_t fullScanChunkNext = 0; // index into autoRescanTestChannelList (all 5 GHz channels) of the next chunk channel
+        uint32_t fullScanChunkInBurst = 0; // channels scanned since the radio last stayed home
+        unsigned long fullScanChunkResumeTime = 0; // the next chunk starts no earlier than this (ms)
+        unsigned long fullScanChunkStartTime = 0; // when the chunked full scan began (ms)
+        size_t fullScanChunkStep = 0; // step on the current channel: directed scans first, then the undirected one
+        size_t fullScanChunkSteps = 1; // steps per channel, latched when the scan began
+        bool fullScanChunkDirected = false; // directedScans latched when the scan began
+        uint32_t fullScanChunkChannelStartMs = 0; // when the scan moved to the current channel; entries heard since count as seen
+        uint32_t fullScanChunkRecords = 0; // scan records returned so far in this full scan
+        uint32_t lastFullScanRecords = 0; // scan records returned by the last complete chunked full scan
+        // SSID-directed full scans (persisted): each channel is probed once per known SSID (knownNetworks order).
+        // WiFi.scanNetworks() has a single SSID parameter that both directs the probes and makes the driver drop
+        // every other response, so with directedScanFilter the result sets only hold known SSIDs. Without it,
+        // an undirected scan of the channel follows, so unknown networks are still listed. Implies chunked scans.
+        bool directedScans = false;
+        bool directedScanFilter = true;
+        uint32_t directedScanDwellMs = 30; // active dwell per channel and SSID; probe responses come within a few ms
         bool autoRescanActive = false;
         size_t autoRescanIndex = 0;
-        String autoRescanTargetBssid = "";
+        uint64_t autoRescanTargetBssid = 0; // packed BSSID of the network being rescanned
         uint8_t autoRescanTargetChannel = 0;
         bool autoRescanSweepDidScan = false; // true if this rescan sweep actually started at least one scan
         bool autoRescanKnownOnly = false; // true if the current rescan sweep only targets known networks; for now managed by startAutoRescanNext(knownOnly)
         bool autoRescanTestChannels = true; // if true, after full auto-rescan sweep, also test one channel
         bool autoRescanSkipNotDetected = true; // if true, skip non-detected networks during rescan to avoid wasting resources
+        bool autoRescanGroupRadios = true; // if true, one rescan per physical radio also refreshes its other BSSIDs (virtual APs), persisted
+        bool autoRescanByChannel = false; // if true, sweeps scan each channel once (no BSSID filter) instead of each BSSID, persisted
+        // Priority scheduler (persisted): instead of walking the list in order, each sweep rescans the entries whose
+        // deadline passed, most overdue first. Deadlines lie between the min and max interval, shorter for volatile
+        // RSSIs and for roam candidates close to the roam threshold, and backing off for entries that went missing.
+        bool autoRescanPriority = true;
+        float autoRescanMinIntervalSec = 2.0f;
+        float autoRescanMaxIntervalSec = 30.0f;
+        bool autoRescanSweepPriority = false; // autoRescanPriority latched at the start of the current sweep
+        bool autoRescanSweepByChannel = false; // autoRescanByChannel latched at the start of the current sweep
+        uint32_t autoRescanSweepChannels[8] = {0}; // bitset of channels already scanned in the current channel-grouped sweep
+        bool autoRescanTestChannelDone = false; // the test channel of the current sweep has been scanned
+        unsigned long lastTestChannelTime = 0; // when the last test channel scan was queued
+        unsigned long lastScanStartTime = 0; // when the current/last async scan was started (ms)
+        unsigned long autoRescanSweepStartTime = 0; // when the current sweep started its first scan (ms)
+        uint32_t autoRescanSweepScans = 0; // scans issued in the current sweep
+        uint32_t autoRescanSweepRadioMs = 0; // time spent scanning in the current sweep (ms)
+        // Completed-sweep metrics per sweep mode, to compare per-BSSID and channel-grouped sweeps
+        struct RescanSweepStats {
+            uint32_t sweeps = 0;
+            uint32_t lastDurationMs = 0; // first scan start to sweep end, including the waits between scans
+            uint32_t lastRadioMs = 0;    // time the radio spent scanning
+            uint32_t lastScans = 0;
+            float avgDurationMs = 0.0f;  // running means over all sweeps of this mode
+            float avgRadioMs = 0.0f;
+        };
+        RescanSweepStats rescanSweepStats[2]; // [0] = per-BSSID sweeps, [1] = channel-grouped sweeps
+        uint32_t autoRescanSharedRadioSkipCount = 0; // rescans saved by radio grouping, since boot
         float autoRescanWaitIntervalSec = 10.0f; // wait time between consecutive series of scans during auto-rescan (seconds), persisted
         unsigned long lastAutoRescanSingleScanTime = 0; // timestamp when last single network scan completed (ms)
         int autoRescanTestChannelIndex = -1; // last channel tested if autoRescanTestChannels is true
+        // Discovery statistics per entry of autoRescanTestChannelList (persisted as one blob, see saveTestChannelStats())
+        struct TestChannelStats {
+            uint16_t yieldQ8 = 0;     // running mean of BSSIDs new or detected again per test scan, in 1/256 units
+            uint16_t scans = 0;       // test scans of this channel (saturating)
+            uint32_t discovered = 0;  // BSSIDs new or detected again, in total
+            uint32_t lastTestSeq = 0; // testChannelSeq at the last test scan of this channel, 0 = never
+        };
+        std::vector<TestChannelStats> testChannelStats; // parallel to autoRescanTestChannelList
+        uint32_t testChannelSeq = 0; // counts test scans, orders channels by when they were last tested
+        float testChannelExploreRate = 0.2f; // share of test scans given to the least recently tested channel instead of the best yield, persisted
+        unsigned long testChannelStatsSavedTime = 0; // when the statistics were last written to NVS (ms)
+        static constexpr uint32_t TestChannelStatsSaveIntervalMs = 600000; // limits NVS writes of the statistics
         std::vector<int> autoRescanTestChannelList = {36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165, 169, 173, 177}; // list of channels to test if autoRescanTestChannels is true
         bool connectionRequested = false; // Flag for connection request from web interface
         bool connectionTargetRequested = false; // Flag for targeted connection request from web interface
+        // Scan requests from the web interface, carried out by handleScanRequests(); only the loop touches scanJobs
+        bool manualRescanRequested = false;
+        bool manualFullScanRequested = false;
+        bool sweepResetRequested = false; // scan settings changed: drop the running rescan sweep
         String connectionTargetSSID = "";
         String connectionTargetBSSID = "";
         int connectionTargetChannel = 0;
@@ -162,6 +429,30 @@ class RoamingWiFiManager {
         bool autoRoamEnabled = true; // Enable auto-connect to stronger network
         float autoRoamDeltaRssiDbm = 10.0f; // Minimum RSSI delta (dBm) to trigger roam
         bool autoRoamSameSsidOnly = true; // If true, only roam within the same SSID
+        // Candidate scoring (persisted): connect and roam candidates are ranked by ApScoring::multiFactor (RSSI,
+        // link rate from PHY and width, BSS Load, DFS, recent connect failures) instead of RSSI alone.
+        bool autoRoamScoring = true;
+        uint32_t scoreDfsPenaltyDb = 3;
+        uint32_t scoreFailPenaltyDb = 8; // per recent failed connect, up to ApScoring::FailuresCounted
+        ApScoreFunction customScoreFunction = nullptr; // see setScoreFunction()
+        ApScore scoreNetwork(const ScannedNetwork& net, int8_t rssi) const;
+        const char* scoreFunctionName() const;
+        // Recent failed connects per BSSID, for the score. A failure is forgotten after ConnectFailureMemoryMs
+        // or once connected to that BSSID.
+        struct ConnectFailure {
+            uint64_t bssidKey;
+            uint32_t timeMs; // latest failure
+            uint8_t count;   // 0 = free slot
+        };
+        static constexpr size_t ConnectFailureSlots = 4;
+        static constexpr uint32_t ConnectFailureMemoryMs = 300000;
+        ConnectFailure connectFailures[ConnectFailureSlots] = {};
+        bool connectFailEventPending = false; // disconnect event of an attempt that never connected; under connectionMux
+        uint64_t connectFailEventBssid = 0;   // under connectionMux, with connectFailEventPending
+        uint8_t connectFailureCount(uint64_t bssidKey) const;
+        void noteConnectFailure(uint64_t bssidKey, uint32_t nowMs);
+        void handleConnectFailures(); // records pending failures, forgets old ones
+        void rescoreNetwork(uint64_t bssidKey); // after its failures changed
         Preferences wifiPrefs;            // NVS preferences for persistence
         String savedBSSID = "";          // Last successfully connected BSSID (persisted)
         String savedSSID = "";           // Last successfully connected SSID (persisted)
@@ -174,6 +465,9 @@ class RoamingWiFiManager {
 
         // Like, wifi connected/disconnected etc
         void handleWiFiEvent(WiFiEvent_t event, arduino_event_info_t info);
+        // WIFI_EVENT_STA_BSS_RSSI_LOW has no Arduino event, so it is taken from the IDF event loop directly.
+        // Runs in the event task: only records the event for updateLinkLevel().
+        static void handleRssiLowEvent(void* arg, esp_event_base_t, int32_t, void* data);
         // Helper to send a unified 401 Unauthorized response with WWW-Authenticate header
         void sendUnauthorized(AsyncWebServerRequest *request, const char* message);
         bool checkHttpAuth(AsyncWebServerRequest *request); // check HTTP Basic Auth
@@ -184,6 +478,49 @@ class RoamingWiFiManager {
         // If keepExisting is true: keep list entries, update/append scanned ones, and mark missing as not detected.
         void copyScannedNetworksToList(bool keepExisting);
         void sortNetworks(); // first all known networks (sorted by RSSI), then unknown networks (sorted by RSSI)
+        static bool sortsBefore(const ScannedNetwork& a, const ScannedNetwork& b); // sortNetworks() ordering
+        static constexpr size_t SortInsertionMaxDirty = 16; // above this many out-of-order pairs, use std::sort
+        // AP table helpers: O(1) lookup of scannedNetworkList entries by packed BSSID
+        int findNetworkIndex(uint64_t bssidKey) const; // returns -1 if not in scannedNetworkList
+        void addNetwork(const ScannedNetwork& net); // appends to scannedNetworkList and indexes it
+        void rebuildNetworkIndex();
+        // Scan results are read in place from the records the Arduino core already fetched (no String copies).
+        static const wifi_ap_record_t* getScanRecord(int scanIndex); // nullptr if out of range
+        void updateNetworkFromRecord(ScannedNetwork& entry, const wifi_ap_record_t& rec); // copies one scan record into entry
+        static void updateCapabilitiesFromRecord(ApCapabilities& caps, const wifi_ap_record_t& rec); // keeps beacon-only fields
+        int mergeScanRecord(const wifi_ap_record_t& rec, bool& added); // updates or appends the entry for rec.bssid, returns its position
+        // Which new unknown BSSIDs of one scan result set may enter the table (see apUnknownTopK/apDropUnknown)
+        struct UnknownAdmission {
+            bool none = false;    // no new unknown BSSIDs at all
+            int8_t minRssi = -128; // weakest admitted RSSI
+            uint16_t atMinLeft = 0xFFFF; // how many more records exactly at minRssi may be admitted
+        };
+        UnknownAdmission computeUnknownAdmission(int scanCount) const; // top-K cutoff from an RSSI histogram of the scan
+        bool admitScanRecord(const wifi_ap_record_t& rec, UnknownAdmission& admission); // true for known or already stored BSSIDs
+        void setNetworkSsid(ScannedNetwork& entry, const char* ssid); // copies ssid and resolves credentialId only if it changed
+        void noteNetworkChanged(const ScannedNetwork& entry); // call after changing rssi/detected/scanned of an entry
+        void refreshRadioMembers(const ScannedNetwork& source); // copies a fresh rescan result to the other BSSIDs of its radio
+        int mergeChannelScanResults(int scanCount); // merges a single-channel scan without BSSID filter into the AP table, returns the BSSIDs new or detected again
+        int selectTestChannel(); // index into autoRescanTestChannelList of the next test channel, by expected yield
+        void recordTestChannelYield(int listIndex, int discovered); // updates testChannelStats after a test scan
+        bool isRescanEligible(ScannedNetwork& candidate, bool markSkipped); // sweep filters; markSkipped also marks/logs skipped entries
+        size_t selectDueRescanEntry(); // priority scheduler: most overdue eligible entry, or scannedNetworkList.size()
+        uint32_t rescanIntervalMs(const ScannedNetwork& entry) const; // priority scheduler: time until the next rescan of entry
+        void scheduleRescan(ScannedNetwork& entry); // sets entry.nextRescanMs from rescanIntervalMs()
+        uint16_t dwellTimeMs(uint8_t channel, const ScannedNetwork* target) const; // scan time for a single-channel scan
+        void noteDwellOutcome(uint8_t channel, bool hit); // the last single-channel scan found (or missed) what it looked for
+        void noteDwellMiss(ScannedNetwork& entry); // the last dwell missed entry, call before clearing entry.detected
+        void noteFalseEmpty(ScannedNetwork& entry); // a dwell missed entry although it was present
+        void finishRescanSweepStats(); // records the metrics of a completed rescan sweep
+        void refreshRoamCandidates(); // refills roamCandidates lists invalidated by removals
+        uint64_t getConnectedBssidKey() const; // 0 if not connected
+        int8_t getConnectedRssi(); // RSSI of the connected AP, re-sampled at most every ConnectionRssiMaxAgeMs
+        void noteRssiSample(ScannedNetwork& entry, int8_t rssi); // a fresh detection of entry at rssi
+        // Drops entries older than apTableMaxAgeSec, then unknown entries beyond the ingestion policy,
+        // then the least useful ones until the table fits apTableCapacity.
+        // Only call between scans: positions change (autoRescanIndex is adjusted).
+        void enforceApTableLimits();
+        std::vector<uint32_t> evictionCandidates; // scratch of enforceApTableLimits(): table positions, reused
         void printNetworks();
         ScannedNetwork findBestNetworkVar();
         void connectToStrongestNetwork(); // strongest in scannedNetworks
@@ -194,20 +531,43 @@ class RoamingWiFiManager {
 
         // full scan
         void scanNetworksFullAsync();
+        void applyScanHomeDwell(); // sets the driver's home-channel dwell for the full scan about to start
+        // Chunked full scan: one single-channel job per channel of autoRescanTestChannelList
+        bool useChunkedFullScan() const; // a full scan started now would run in chunks
+        void beginChunkedFullScan(const ScanJob& job);
+        ScanJob makeFullScanChunkJob() const; // job for the channel at fullScanChunkNext
+        void advanceChunkedFullScan(); // after a chunk completed or failed
+        void publishFullScanChunk(); // lets roaming/reconnecting act on the channel just merged
+        void finishFullScan(ScanPurpose purpose); // bookkeeping shared by burst and chunked full scans
 
         // async rescan of a single network based on known channel and bssid, usually taken from scannedNetworkList[autoRescanIndex]
         // if bssid is empty, scan all BSSIDs on that channel
-        void scanNetworkAsync(uint8_t channel, const uint8_t* bssid);
+        void scanNetworkAsync(uint8_t channel, const uint8_t* bssid, const char* ssid = nullptr);
 
         // Rescan existing networks only.
         // Returns true if at least one network was found to rescan, false if scan in progress or no network found to scan.
         // knownOnly: if true, only networks in knownNetworks are considered for rescanning. This speeds up quick scanning of interesting channels.
-        bool startAutoRescanNext(bool knownOnly);
+        // Queues the next step of the sweep as a scan job; does not scan itself.
+        bool startAutoRescanNext(bool knownOnly, ScanJobPriority priority = ScanJobPriority::Rescan);
+        uint32_t autoRescanWaitRemainingMs() const; // time left of autoRescanKnownIntervalSec since the last rescan
+
+        // Scan job queue
+        void enqueueScanJob(ScanJob job);
+        bool dispatchScanJobs(); // starts the most urgent job if the radio is free; returns true if a scan was started
+        bool startScanJob(const ScanJob& job); // false if the job became obsolete while it waited
+        void preemptScan(ScanJobPriority priority); // aborts the running scan if it is a Rescan/Discovery one less urgent than priority
+        bool scanJobPending(ScanPurpose purpose) const; // queued or running
+        bool sweepJobPending() const; // a step of the rescan sweep is queued or running
+        void removeSweepJobs();
+        void resetRescanSweep(); // drops the running rescan sweep and its queued step
+        void handleScanRequests(); // queues the scans requested through the web interface
+        uint32_t scanJobAirtimeMs(const ScanJob& job) const; // estimated off-channel time, 0 if not connected or on the home channel
+        void noteScanEnded(); // books the off-channel time of the scan that just ended
 
         String getPasswordOfNetwork(String ssid); // returns empty string if ssid not found in list of known networks
         JsonDocument getScannedNetworksAsJsonDocument();
 
-        bool isKnownSsid(const String& ssid);
+        bool isKnownSsid(const char* ssid);
 
         // JSON helpers
         void sendJsonError(AsyncWebServerRequest* request, int code, const char* message);
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// Alpha-beta tracker of one BSSID's RSSI: a smoothed level, its slope, and the variance of the samples
+// around the track. Fixed point in 6 bytes, so it fits the trivially copyable AP table entry; a
+// value-initialized filter is empty and takes its first sample as is.
+class RssiFilter {
+public:
+    static constexpr float Alpha = 0.35f;            // level gain
+    static constexpr float Beta = 0.05f;             // slope gain
+    static constexpr float MinSlopeDtSec = 0.5f;     // closer samples don't steepen the slope further
+    static constexpr float MaxSlopeDbPerSec = 20.0f;
+    static constexpr uint32_t RestartGapMs = 30000;  // after a longer gap the old track is dropped
+
+    bool empty() const {
+        return levelQ4 == 0; // 0 dBm is not a level any AP is heard at
+    }
+
+    void reset(int8_t rssi) {
+        levelQ4 = clampLevelQ4(rssi * 16.0f);
+        slopeQ8 = 0;
+        varianceQ4 = 0;
+    }
+
+    // Feeds one sample taken dtMs after the previous one.
+    void update(int8_t rssi, uint32_t dtMs) {
+        if (empty() || dtMs > RestartGapMs) {
+            reset(rssi);
+            return;
+        }
+        const float dt = (float)dtMs / 1000.0f;
+        const float predicted = level() + slopeDbPerSec() * dt;
+        const float residual = (float)rssi - predicted;
+        float slope = slopeDbPerSec() + Beta * residual / (dt > MinSlopeDtSec ? dt : MinSlopeDtSec);
+        slope = slope > MaxSlopeDbPerSec ? MaxSlopeDbPerSec : (slope < -MaxSlopeDbPerSec ? -MaxSlopeDbPerSec : slope);
+        levelQ4 = clampLevelQ4((predicted + Alpha * residual) * 16.0f);
+        slopeQ8 = (int16_t)lroundf(slope * 256.0f);
+        const float variance = varianceDb2() + (residual * residual - varianceDb2()) / 8.0f;
+        varianceQ4 = (uint16_t)(variance < 4095.0f ? lroundf(variance * 16.0f) : 65535);
+    }
+
+    float level() const { return levelQ4 / 16.0f; }
+    int8_t rssi() const { return (int8_t)((levelQ4 - 8) / 16); } // rounded to the nearest dB
+    float slopeDbPerSec() const { return slopeQ8 / 256.0f; }
+    float varianceDb2() const { return varianceQ4 / 16.0f; }
+    float stdDevDb() const { return sqrtf(varianceDb2()); }
+
+private:
+    int16_t levelQ4 = 0;     // 1/16 dB
+    int16_t slopeQ8 = 0;     // 1/256 dB/s
+    uint16_t varianceQ4 = 0; // 1/16 dB^2
+
+    static int16_t clampLevelQ4(float q4) {
+        return (int16_t)(q4 < -127.0f * 16.0f ? -127 * 16 : (q4 > -16.0f ? -16 : lroundf(q4)));
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Scan job priorities, most urgent first. Jobs of the two lowest priorities may be preempted.
+enum class ScanJobPriority : uint8_t {
+    Reconnect = 0,  // not connected and nothing known to connect to
+    RoamVerify = 1, // confirm a roam candidate before switching to it
+    Manual = 2,     // requested through the web UI
+    Rescan = 3,     // automatic rescan sweeps
+    Discovery = 4,  // automatic full scans and test channels
+};
+
+inline const char* toString(ScanJobPriority priority) {
+    switch (priority) {
+        case ScanJobPriority::Reconnect: return "reconnect";
+        case ScanJobPriority::RoamVerify: return "roamVerify";
+        case ScanJobPriority::Manual: return "manual";
+        case ScanJobPriority::Rescan: return "rescan";
+        case ScanJobPriority::Discovery: return "discovery";
+        default: return "unknown";
+    }
+}
+
+struct ScanJob {
+    static constexpr uint8_t NoSsid = 0xFF;
+
+    ScanJobPriority priority = ScanJobPriority::Discovery;
+    uint8_t purpose = 0;       // owner-defined kind of scan (RoamingWiFiManager::ScanPurpose)
+    uint8_t channel = 0;       // 0 = all channels
+    bool filterBssid = false;  // scan for bssidKey only
+    uint64_t bssidKey = 0;     // target AP table entry, if any
+    uint8_t ssidIndex = NoSsid; // owner-defined SSID to direct the probes at, if any
+    uint32_t enqueuedMs = 0;   // kept when a preempted job is queued again
+    uint32_t seq = 0;          // FIFO order within a priority, assigned by push()
+};
+
+// Small fixed-capacity priority queue of pending scans; most urgent priority first, FIFO within a priority.
+// Also keeps the wait-time statistics of the jobs started from it.
+class ScanJobQueue {
+public:
+    static constexpr size_t Capacity = 8;
+
+    // Queues job. When full, the least urgent job makes room if job is more urgent; otherwise job is dropped.
+    bool push(const ScanJob& job) {
+        ScanJob queued = job;
+        if (queued.seq == 0) {
+            queued.seq = ++nextSeq;
+        }
+        if (count == Capacity) {
+            const size_t worst = worstIndex();
+            if (!before(queued, jobs[worst])) {
+                droppedCount++;
+                return false;
+            }
+            jobs[worst] = jobs[--count];
+            droppedCount++;
+        }
+        jobs[count++] = queued;
+        if (count > maxDepthSeen) {
+            maxDepthSeen = count;
+        }
+        return true;
+    }
+
+    // Most urgent job, or nullptr if empty.
+    const ScanJob* peek() const {
+        return count == 0 ? nullptr : &jobs[bestIndex()];
+    }
+
+    bool pop(ScanJob& out) {
+        if (count == 0) {
+            return false;
+        }
+        const size_t best = bestIndex();
+        out = jobs[best];
+        jobs[best] = jobs[--count];
+        return true;
+    }
+
+    bool contains(uint8_t purpose) const {
+        for (size_t i = 0; i < count; i++) {
+            if (jobs[i].purpose == purpose) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Removes all jobs of one purpose, e.g. the pending step of a cancelled sweep.
+    void remove(uint8_t purpose) {
+        for (size_t i = 0; i < count;) {
+            if (jobs[i].purpose == purpose) {
+                jobs[i] = jobs[--count];
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // Records the wait of a job that is being started now.
+    void noteStarted(const ScanJob& job, uint32_t nowMs) {
+        lastWait = nowMs - job.enqueuedMs;
+        if (lastWait > maxWait) {
+            maxWait = lastWait;
+        }
+        startedCount++;
+        avgWait += ((float)lastWait - avgWait) / (startedCount < 16 ? (float)startedCount : 16.0f);
+    }
+
+    size_t size() const { return count; }
+    size_t maxDepth() const { return maxDepthSeen; }
+    uint32_t started() const { return startedCount; }
+    uint32_t dropped() const { return droppedCount; }
+    uint32_t lastWaitMs() const { return lastWait; }
+    uint32_t maxWaitMs() const { return maxWait; }
+    float avgWaitMs() const { return avgWait; } // running mean over about the last 16 jobs
+
+private:
+    ScanJob jobs[Capacity];
+    size_t count = 0;
+    size_t maxDepthSeen = 0;
+    uint32_t nextSeq = 0;
+    uint32_t startedCount = 0;
+    uint32_t droppedCount = 0;
+    uint32_t lastWait = 0;
+    uint32_t maxWait = 0;
+    float avgWait = 0.0f;
+
+    static bool before(const ScanJob& a, const ScanJob& b) {
+        return a.priority != b.priority ? a.priority < b.priority : (int32_t)(a.seq - b.seq) < 0;
+    }
+    size_t bestIndex() const {
+        size_t best = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (before(jobs[i], jobs[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+    size_t worstIndex() const {
+        size_t worst = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (before(jobs[worst], jobs[i])) {
+                worst = i;
+            }
+        }
+        return worst;
+    }
+};
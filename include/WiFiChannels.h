@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+
+// True for the 5 GHz channels that need radar detection (DFS): 52-64 and 100-144. APs on them may
+// be slow to answer probes and can be forced off the channel. Shared by scan dwell and AP scoring.
+inline bool isDfsChannel(uint8_t channel) {
+    return (channel >= 52 && channel <= 64) || (channel >= 100 && channel <= 144);
+}
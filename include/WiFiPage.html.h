@@ -165,6 +165,10 @@ const char WIFI_HTML[] PROGMEM = R"MyString(<!DOCTYPE html>
             Networks last scanned (sec ago): <span id="networksScanAgeSecValue">N/A</span>
             &nbsp;|&nbsp;
             Scan count: <span id="networksScanCountValue">N/A</span>
+            <span id="networksScanProgress" style="display:none">
+                &nbsp;|&nbsp;
+                Full scan: <span id="networksScanProgressValue"></span>
+            </span>
         </div>
 
         <div class="signal-graph">
@@ -560,6 +564,24 @@ const char WIFI_HTML[] PROGMEM = R"MyString(<!DOCTYPE html>
             networksScanType = v.length ? v : null;
         }
 
+        function setNetworksScanProgressFromServer(progress) {
+            const wrap = document.getElementById('networksScanProgress');
+            const el = document.getElementById('networksScanProgressValue');
+            if (!wrap || !el) return;
+            if (!progress || !progress.active) {
+                wrap.style.display = 'none';
+                return;
+            }
+            if (progress.progressive) {
+                const done = Number(progress.channelsDone) || 0;
+                const total = Number(progress.channelsTotal) || 0;
+                el.textContent = done + '/' + total + ' channels (scanning ch ' + progress.channel + ')';
+            } else {
+                el.textContent = 'in progress';
+            }
+            wrap.style.display = '';
+        }
+
         function restartStatusAutoRefreshTimer() {
             if (statusAutoRefreshTimer) {
                 clearInterval(statusAutoRefreshTimer);
@@ -1197,6 +1219,7 @@ const char WIFI_HTML[] PROGMEM = R"MyString(<!DOCTYPE html>
                     setNetworksScanAgeFromServer(data.scanAgeSec);
                     setNetworksScanCountFromServer(data.scanCount);
                     setNetworksScanTypeFromServer(data.scanType);
+                    setNetworksScanProgressFromServer(data.fullScanProgress);
                     clientIps = (data && Array.isArray(data.clientIps)) ? data.clientIps : [];
                     networksData = (data && Array.isArray(data.networks)) ? data.networks : [];
                     // Reset to default: no sorting, keep original order each fetch
@@ -1,6 +1,10 @@
 #include "RoamingWiFiManager.h"
 #include <WiFi.h>
 #include <algorithm>
+#include <math.h>
+#include <esp_wifi.h>
+#include <esp_event.h>
+#include <soc/soc_caps.h>
 #include <mbedtls/base64.h>
 
 #include "WiFiPage.html.h" // contains the WIFI_HTML string
@@ -33,6 +37,14 @@ String RoamingWiFiManager::toString(ScanPurpose purpose) {
             return "autoRescanSingle";
         case ScanPurpose::AutoRescanTestChannel:
             return "autoRescanTestChannel";
+        case ScanPurpose::AutoRescanChannel:
+            return "autoRescanChannel";
+        case ScanPurpose::RoamVerify:
+            return "roamVerify";
+        case ScanPurpose::ReconnectFull:
+            return "reconnectFull";
+        case ScanPurpose::FullScanChunk:
+            return "fullScanChunk";
         case ScanPurpose::None:
             return "none";
         default:
@@ -40,6 +52,42 @@ String RoamingWiFiManager::toString(ScanPurpose purpose) {
     }
 }
 
+const char* RoamingWiFiManager::toString(FullScanMode mode) {
+    switch (mode) {
+        case FullScanMode::Burst:
+            return "burst";
+        case FullScanMode::HomeDwell:
+            return "homeDwell";
+        case FullScanMode::Chunked:
+            return "chunked";
+        default:
+            return "unknown";
+    }
+}
+
+const char* RoamingWiFiManager::toString(LinkLevel level) {
+    switch (level) {
+        case LinkLevel::Good:
+            return "good";
+        case LinkLevel::Weak:
+            return "weak";
+        case LinkLevel::Edge:
+            return "edge";
+        default:
+            return "unknown";
+    }
+}
+
+bool RoamingWiFiManager::parseFullScanMode(const char* name, FullScanMode& mode) {
+    for (FullScanMode candidate : {FullScanMode::Burst, FullScanMode::HomeDwell, FullScanMode::Chunked}) {
+        if (strcmp(name, toString(candidate)) == 0) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool RoamingWiFiManager::parseBssid(const String& bssidStr, uint8_t bssid[6]) {
     return (sscanf(bssidStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
         &bssid[0], &bssid[1], &bssid[2], &bssid[3], &bssid[4], &bssid[5]) == 6);
@@ -135,6 +183,39 @@ void RoamingWiFiManager::loadScanSettings() {
     }
     autoRescanSkipNotDetected = wifiPrefs.getBool("autoRescSkipNd", true);
 
+    // Whether BSSIDs that share one physical radio (virtual APs) are rescanned once per sweep.
+    if (!wifiPrefs.isKey("autoRescGrpRad")) {
+        wifiPrefs.putBool("autoRescGrpRad", true);
+    }
+    autoRescanGroupRadios = wifiPrefs.getBool("autoRescGrpRad", true);
+
+    // Whether rescan sweeps scan each channel once instead of each BSSID.
+    // Default to false to preserve previous behavior.
+    if (!wifiPrefs.isKey("autoRescByCh")) {
+        wifiPrefs.putBool("autoRescByCh", false);
+    }
+    autoRescanByChannel = wifiPrefs.getBool("autoRescByCh", false);
+
+    // Priority scheduler for rescans, with its min/max rescan interval per entry.
+    if (!wifiPrefs.isKey("autoRescPrio")) {
+        wifiPrefs.putBool("autoRescPrio", true);
+    }
+    autoRescanPriority = wifiPrefs.getBool("autoRescPrio", true);
+    if (!wifiPrefs.isKey("autoRescMinSecF")) {
+        wifiPrefs.putFloat("autoRescMinSecF", 2.0f);
+    }
+    if (!wifiPrefs.isKey("autoRescMaxSecF")) {
+        wifiPrefs.putFloat("autoRescMaxSecF", 30.0f);
+    }
+    float vMinSec = wifiPrefs.getFloat("autoRescMinSecF", 2.0f);
+    float vMaxSec = wifiPrefs.getFloat("autoRescMaxSecF", 30.0f);
+    if (!(vMinSec >= 0.1f && vMinSec <= 3600.0f && vMaxSec >= vMinSec && vMaxSec <= 3600.0f)) {
+        vMinSec = 2.0f;
+        vMaxSec = 30.0f;
+    }
+    autoRescanMinIntervalSec = vMinSec;
+    autoRescanMaxIntervalSec = vMaxSec;
+
     // Wait interval between consecutive scans during auto-rescan.
     // Default to 10.0 sec.
     if (!wifiPrefs.isKey("autoRescWaSecF")) {
@@ -164,6 +245,201 @@ void RoamingWiFiManager::loadScanSettings() {
         vDfs = 200;
     }
     scanTimeDfsMs = vDfs;
+
+    // Adaptive dwell: learned scan time per channel, within bounds
+    if (!wifiPrefs.isKey("dwellAdaptive")) {
+        wifiPrefs.putBool("dwellAdaptive", true);
+    }
+    adaptiveDwell = wifiPrefs.getBool("dwellAdaptive", true);
+    if (!wifiPrefs.isKey("dwellMinMs")) {
+        wifiPrefs.putUInt("dwellMinMs", 20);
+    }
+    if (!wifiPrefs.isKey("dwellMaxMs")) {
+        wifiPrefs.putUInt("dwellMaxMs", 400);
+    }
+    uint32_t vDwellMin = wifiPrefs.getUInt("dwellMinMs", 20);
+    uint32_t vDwellMax = wifiPrefs.getUInt("dwellMaxMs", 400);
+    if (!(vDwellMin >= 10 && vDwellMax >= vDwellMin && vDwellMax <= 1000)) {
+        vDwellMin = 20;
+        vDwellMax = 400;
+    }
+    dwellMinMs = vDwellMin;
+    dwellMaxMs = vDwellMax;
+    channelDwell.setBounds((uint16_t)dwellMinMs, (uint16_t)dwellMaxMs);
+
+    // Off-channel airtime budget for background scans while connected
+    if (!wifiPrefs.isKey("airtimePctF")) {
+        wifiPrefs.putFloat("airtimePctF", 10.0f);
+    }
+    if (!wifiPrefs.isKey("airtimeWinMs")) {
+        wifiPrefs.putUInt("airtimeWinMs", 1000);
+    }
+    float vAirPct = wifiPrefs.getFloat("airtimePctF", 10.0f);
+    if (!(vAirPct >= 1.0f && vAirPct <= 100.0f)) {
+        vAirPct = 10.0f;
+    }
+    uint32_t vAirWin = wifiPrefs.getUInt("airtimeWinMs", 1000);
+    if (!(vAirWin >= 100 && vAirWin <= 10000)) {
+        vAirWin = 1000;
+    }
+    airtimeBudgetPercent = vAirPct;
+    airtimeWindowMs = vAirWin;
+    airtime.configure(airtimeBudgetPercent, airtimeWindowMs);
+
+    // Full scans while connected: home-channel returns
+    if (!wifiPrefs.isKey("fullScanMode")) {
+        wifiPrefs.putUChar("fullScanMode", (uint8_t)FullScanMode::Chunked);
+    }
+    if (!wifiPrefs.isKey("fullScanHomeMs")) {
+        wifiPrefs.putUInt("fullScanHomeMs", 100);
+    }
+    if (!wifiPrefs.isKey("fullScanChunk")) {
+        wifiPrefs.putUInt("fullScanChunk", 2);
+    }
+    uint8_t vFullMode = wifiPrefs.getUChar("fullScanMode", (uint8_t)FullScanMode::Chunked);
+    if (vFullMode > (uint8_t)FullScanMode::Chunked) {
+        vFullMode = (uint8_t)FullScanMode::Chunked;
+    }
+    uint32_t vHomeMs = wifiPrefs.getUInt("fullScanHomeMs", 100);
+    if (!(vHomeMs >= 30 && vHomeMs <= 1000)) {
+        vHomeMs = 100;
+    }
+    uint32_t vChunk = wifiPrefs.getUInt("fullScanChunk", 2);
+    if (!(vChunk >= 1 && vChunk <= 28)) {
+        vChunk = 2;
+    }
+    fullScanConnectedMode = (FullScanMode)vFullMode;
+    fullScanHomeDwellMs = vHomeMs;
+    fullScanChunkChannels = vChunk;
+
+    if (!wifiPrefs.isKey("fullScanProgr")) {
+        wifiPrefs.putBool("fullScanProgr", true);
+    }
+    fullScanProgressive = wifiPrefs.getBool("fullScanProgr", true);
+
+    // RSSI-event driven scanning while connected
+    if (!wifiPrefs.isKey("rssiEvtEn")) {
+        wifiPrefs.putBool("rssiEvtEn", false);
+    }
+    if (!wifiPrefs.isKey("rssiRescDbm")) {
+        wifiPrefs.putInt("rssiRescDbm", -70);
+    }
+    if (!wifiPrefs.isKey("rssiFullDbm")) {
+        wifiPrefs.putInt("rssiFullDbm", -80);
+    }
+    if (!wifiPrefs.isKey("rssiHystDb")) {
+        wifiPrefs.putUInt("rssiHystDb", 5);
+    }
+    if (!wifiPrefs.isKey("rssiEdgeSecF")) {
+        wifiPrefs.putFloat("rssiEdgeSecF", 10.0f);
+    }
+    rssiEventScanning = wifiPrefs.getBool("rssiEvtEn", false);
+    int32_t vRescDbm = wifiPrefs.getInt("rssiRescDbm", -70);
+    int32_t vFullDbm = wifiPrefs.getInt("rssiFullDbm", -80);
+    if (!(vRescDbm >= -100 && vRescDbm <= -30 && vFullDbm >= -100 && vFullDbm < vRescDbm)) {
+        vRescDbm = -70;
+        vFullDbm = -80;
+    }
+    uint32_t vHyst = wifiPrefs.getUInt("rssiHystDb", 5);
+    if (vHyst > 20) {
+        vHyst = 5;
+    }
+    float vEdgeSec = wifiPrefs.getFloat("rssiEdgeSecF", 10.0f);
+    if (!(vEdgeSec >= 1.0f && vEdgeSec <= 3600.0f)) {
+        vEdgeSec = 10.0f;
+    }
+    rssiRescanThresholdDbm = vRescDbm;
+    rssiFullScanThresholdDbm = vFullDbm;
+    rssiHysteresisDb = vHyst;
+    rssiEdgeFullIntervalSec = vEdgeSec;
+    rssiArmedBssid = 0;
+
+    // Connected-AP RSSI sampling
+    if (!wifiPrefs.isKey("connRssiMs")) {
+        wifiPrefs.putUInt("connRssiMs", 500);
+    }
+    uint32_t vConnRssiMs = wifiPrefs.getUInt("connRssiMs", 500);
+    if (!(vConnRssiMs == 0 || (vConnRssiMs >= 50 && vConnRssiMs <= 10000))) {
+        vConnRssiMs = 500;
+    }
+    connectedRssiSampleMs = vConnRssiMs;
+
+    // SSID-directed full scans
+    if (!wifiPrefs.isKey("dirScanEn")) {
+        wifiPrefs.putBool("dirScanEn", false);
+    }
+    if (!wifiPrefs.isKey("dirScanFilt")) {
+        wifiPrefs.putBool("dirScanFilt", true);
+    }
+    if (!wifiPrefs.isKey("dirScanDwMs")) {
+        wifiPrefs.putUInt("dirScanDwMs", 30);
+    }
+    directedScans = wifiPrefs.getBool("dirScanEn", false);
+    directedScanFilter = wifiPrefs.getBool("dirScanFilt", true);
+    uint32_t vDirDwell = wifiPrefs.getUInt("dirScanDwMs", 30);
+    if (!(vDirDwell >= 10 && vDirDwell <= 200)) {
+        vDirDwell = 30;
+    }
+    directedScanDwellMs = vDirDwell;
+
+    // Passive beacon harvesting; applied by init() once the settings are loaded
+    if (!wifiPrefs.isKey("harvestEn")) {
+        wifiPrefs.putBool("harvestEn", false);
+    }
+    beaconHarvest = wifiPrefs.getBool("harvestEn", false);
+}
+
+void RoamingWiFiManager::loadTestChannelStats() {
+    if (!wifiPrefs.isKey("testChExplF")) {
+        wifiPrefs.putFloat("testChExplF", 0.2f);
+    }
+    float vExplore = wifiPrefs.getFloat("testChExplF", 0.2f);
+    if (!(vExplore >= 0.0f && vExplore <= 1.0f)) {
+        vExplore = 0.2f;
+    }
+    testChannelExploreRate = vExplore;
+
+    // Discovery statistics; ignored if the channel list changed size since they were saved
+    testChannelStats.assign(autoRescanTestChannelList.size(), TestChannelStats{});
+    const size_t bytes = testChannelStats.size() * sizeof(TestChannelStats);
+    if (wifiPrefs.isKey("testChStats") && wifiPrefs.getBytesLength("testChStats") == bytes) {
+        wifiPrefs.getBytes("testChStats", testChannelStats.data(), bytes);
+    }
+    testChannelSeq = 0;
+    for (const auto& stats : testChannelStats) {
+        testChannelSeq = std::max(testChannelSeq, stats.lastTestSeq);
+    }
+}
+
+void RoamingWiFiManager::saveTestChannelStats() {
+    wifiPrefs.putBytes("testChStats", testChannelStats.data(), testChannelStats.size() * sizeof(TestChannelStats));
+    testChannelStatsSavedTime = millis();
+}
+
+void RoamingWiFiManager::loadApTableSettings() {
+    if (!wifiPrefs.isKey("apTableCap")) wifiPrefs.putUInt("apTableCap", 128);
+    uint32_t cap = wifiPrefs.getUInt("apTableCap", 128);
+    if (!(cap >= 8 && cap <= 1024)) {
+        cap = 128;
+    }
+    apTableCapacity = cap;
+
+    if (!wifiPrefs.isKey("apMaxAgeSecF")) wifiPrefs.putFloat("apMaxAgeSecF", 600.0f);
+    float ageSec = wifiPrefs.getFloat("apMaxAgeSecF", -1.0f);
+    if (!(ageSec >= 0.0f && ageSec <= 86400.0f)) {
+        ageSec = 600.0f;
+    }
+    apTableMaxAgeSec = ageSec;
+
+    if (!wifiPrefs.isKey("apUnkTopK")) wifiPrefs.putUInt("apUnkTopK", 32);
+    uint32_t topK = wifiPrefs.getUInt("apUnkTopK", 32);
+    if (topK > 1024) {
+        topK = 32;
+    }
+    apUnknownTopK = topK;
+
+    if (!wifiPrefs.isKey("apDropUnk")) wifiPrefs.putBool("apDropUnk", false);
+    apDropUnknown = wifiPrefs.getBool("apDropUnk", false);
 }
 
 void RoamingWiFiManager::loadStatusSettings() {
@@ -204,6 +480,17 @@ void RoamingWiFiManager::loadRoamSettings() {
 
     if (!wifiPrefs.isKey("roamSameSsid")) wifiPrefs.putBool("roamSameSsid", true);
     autoRoamSameSsidOnly = wifiPrefs.getBool("roamSameSsid", true);
+
+    if (!wifiPrefs.isKey("roamScoreEn")) wifiPrefs.putBool("roamScoreEn", true);
+    autoRoamScoring = wifiPrefs.getBool("roamScoreEn", true);
+
+    if (!wifiPrefs.isKey("roamDfsPenDb")) wifiPrefs.putUInt("roamDfsPenDb", 3);
+    uint32_t dfsPenalty = wifiPrefs.getUInt("roamDfsPenDb", 3);
+    scoreDfsPenaltyDb = (dfsPenalty <= 30) ? dfsPenalty : 3;
+
+    if (!wifiPrefs.isKey("roamFailPenDb")) wifiPrefs.putUInt("roamFailPenDb", 8);
+    uint32_t failPenalty = wifiPrefs.getUInt("roamFailPenDb", 8);
+    scoreFailPenaltyDb = (failPenalty <= 30) ? failPenalty : 8;
 }
 
 void RoamingWiFiManager::loadDebugLevel() {
@@ -251,6 +538,8 @@ bool RoamingWiFiManager::loadPersistedSettings() {
     loadRoamSettings();
     loadDebugLevel();
     loadNetworkInfo();
+    loadApTableSettings();
+    loadTestChannelStats();
 
     return haveSavedNetwork;
 }
@@ -263,6 +552,16 @@ void RoamingWiFiManager::init(std::vector<NetworkCredentials> credentials, std::
     _adminUser = adminCredentials.first;
     _adminPassword = adminCredentials.second;
     knownNetworks = credentials;
+    {
+        std::vector<const char*> ssids;
+        ssids.reserve(knownNetworks.size());
+        for (const NetworkCredentials& cred : knownNetworks) {
+            ssids.push_back(cred.ssid.c_str());
+        }
+        knownSsids.build(ssids); // knownNetworks must not be modified after this point
+    }
+    roamCandidates.reset(knownNetworks.size());
+    scannedNetworkList.reserve(64); // ScannedNetwork is POD, so the AP table stays one contiguous block
 
     if (knownNetworks.size() == 1) {
         DBG_PRINTF_L(2,"WiFi manager: Initializing known network SSID: %s\n", knownNetworks[0].ssid);
@@ -282,11 +581,16 @@ void RoamingWiFiManager::init(std::vector<NetworkCredentials> credentials, std::
     WiFi.setSleep(false);
     WiFi.setBandMode(WIFI_BAND_MODE_5G_ONLY);
     delay(100);
+    if (esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_BSS_RSSI_LOW, &RoamingWiFiManager::handleRssiLowEvent,
+            this, &rssiLowEventHandler) != ESP_OK) {
+        DBG_PRINTLN_L(1,"WiFi: Could not register the RSSI-low event handler.");
+    }
 
     String stationMac = WiFi.macAddress();
     DBG_PRINTF_L(0,"WiFi: Station MAC: %s\n", stationMac.c_str());
 
     const bool persistedSettingsLoaded = loadPersistedSettings();
+    applyBeaconHarvest();
     wifiPrefs.putBool("lastQuickOK", false); // on next startup it will be false, unless we manage to quick connect
 
     bool fastPathUsed = false;
@@ -307,25 +611,28 @@ void RoamingWiFiManager::init(std::vector<NetworkCredentials> credentials, std::
         DBG_PRINTLN_L(2,"WiFi: Skipping fast reconnect because lastQuickReconnectSuccess is false.");
     }
 
+    syncConnectionSnapshot(); // the connect events of the fast path, before sortNetworks() below uses them
     if (WiFi.isConnected()) {
         DBG_PRINTLN_L(1,"WiFi: Fast reconnect succeeded.");
         // Seed the scan list with the currently-connected network so the UI has
         // something immediately, even before the background async scan completes.
         if (fastPathUsed) {
             const String ssid = WiFi.SSID();
-            const String bssid = WiFi.BSSIDstr();
-            if (ssid.length() > 0 && bssid.length() > 0) {
+            const uint8_t* bssid = WiFi.BSSID();
+            if (ssid.length() > 0 && bssid != nullptr) {
                 scannedNetworkList.clear();
-                ScannedNetwork net;
-                net.ssid = ssid;
-                net.bssid = bssid;
+                scannedNetworkIndex.clear();
+                ScannedNetwork net{};
+                setNetworkSsid(net, ssid.c_str());
+                memcpy(net.bssid, bssid, sizeof(net.bssid));
                 net.rssi = WiFi.RSSI();
                 net.channel = (uint8_t)WiFi.channel();
-                net.encryption = "Unknown";
+                net.authMode = ScannedNetwork::AuthModeUnknown;
                 net.scanned = true;
                 net.detected = true;
-                net.known = isKnownSsid(ssid);
-                scannedNetworkList.push_back(net);
+                net.lastSeenMs = millis();
+                addNetwork(net);
+                roamCandidates.markAllDirty();
                 sortNetworks();
                 lastNetworksScanTime = millis();
                 lastNetworksScanType = "fastReconnect";
@@ -390,12 +697,45 @@ void RoamingWiFiManager::handleWiFiEvent(WiFiEvent_t event, arduino_event_info_t
         case 102: s = "Wifi scan done"; break;
         case 110: s = "Station started"; break;
         case 111: s = "Station stopped"; break;
-        case 112: s = "Station connected"; break;
+        case 112: {
+            s = "Station connected";
+            const wifi_event_sta_connected_t& ev = info.wifi_sta_connected;
+            ConnectionSnapshot snapshot;
+            const size_t len = std::min((size_t)ev.ssid_len, sizeof(snapshot.ssid) - 1);
+            memcpy(snapshot.ssid, ev.ssid, len);
+            snapshot.ssid[len] = '\0';
+            snapshot.credentialIndex = (int16_t)knownSsids.find(snapshot.ssid);
+            snapshot.bssidKey = bssidToKey(ev.bssid);
+            snapshot.channel = ev.channel;
+            snapshot.rssiTimeMs = 0;
+            snapshot.connected = true;
+            portENTER_CRITICAL(&connectionMux);
+            eventConnection = snapshot;
+            eventConnectionChanged = true;
+            portEXIT_CRITICAL(&connectionMux);
+            break;
+        }
         case 113:
             s = "Station disconnected"; 
+            portENTER_CRITICAL(&connectionMux);
+            if (!eventConnection.connected && info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+                // An attempt that never connected (not one we abandoned): counts against that BSSID's score
+                connectFailEventBssid = bssidToKey(info.wifi_sta_disconnected.bssid);
+                connectFailEventPending = true;
+            }
+            eventConnection.connected = false;
+            eventConnection.bssidKey = 0;
+            eventConnection.channel = 0;
+            eventConnection.rssiTimeMs = 0;
+            eventConnectionChanged = true;
+            portEXIT_CRITICAL(&connectionMux);
             stationDisconnected = true;
             break;
-        case 115: s = "Station got IP"; break;
+        case 115:
+            // The event carries no RSSI, and the driver is not called from here: rssiTimeMs is still 0
+            // from the connect event, so the loop samples it
+            s = "Station got IP";
+            break;
         default: s = "Other event"; break;
     }
     DBG_PRINTF_L(4,"WiFi Event: %d: %s\n", event, s.c_str());
@@ -414,6 +754,86 @@ void RoamingWiFiManager::handleWiFiEvent(WiFiEvent_t event, arduino_event_info_t
     }
 }
 
+void RoamingWiFiManager::syncConnectionSnapshot() {
+    portENTER_CRITICAL(&connectionMux);
+    if (eventConnectionChanged) {
+        connection = eventConnection;
+        eventConnectionChanged = false;
+    }
+    portEXIT_CRITICAL(&connectionMux);
+}
+
+void RoamingWiFiManager::handleRssiLowEvent(void* arg, esp_event_base_t, int32_t, void* data) {
+    RoamingWiFiManager* self = static_cast<RoamingWiFiManager*>(arg);
+    const int32_t rssi = static_cast<const wifi_event_bss_rssi_low_t*>(data)->rssi;
+    portENTER_CRITICAL(&self->connectionMux);
+    self->rssiLowEventRssi = rssi;
+    self->rssiLowEventPending = true;
+    portEXIT_CRITICAL(&self->connectionMux);
+}
+
+RoamingWiFiManager::LinkLevel RoamingWiFiManager::linkLevelFor(int rssi) const {
+    LinkLevel level = (rssi < rssiFullScanThresholdDbm) ? LinkLevel::Edge : ((rssi < rssiRescanThresholdDbm) ? LinkLevel::Weak : LinkLevel::Good);
+    if (level < linkLevel) {
+        // Move up only once the RSSI is clearly above the threshold that was crossed
+        const int hysteresis = (int)rssiHysteresisDb;
+        if (linkLevel == LinkLevel::Edge && rssi < rssiFullScanThresholdDbm + hysteresis) {
+            level = LinkLevel::Edge;
+        } else if (rssi < rssiRescanThresholdDbm + hysteresis) {
+            level = LinkLevel::Weak;
+        }
+    }
+    return level;
+}
+
+void RoamingWiFiManager::armRssiThreshold() {
+    // The driver reports a threshold once, so it is armed again after every event
+    if (linkLevel == LinkLevel::Edge) {
+        return; // nothing below; recovery is polled
+    }
+    const int32_t threshold = (linkLevel == LinkLevel::Good) ? rssiRescanThresholdDbm : rssiFullScanThresholdDbm;
+    if (esp_wifi_set_rssi_threshold(threshold) != ESP_OK) {
+        DBG_PRINTF_L(2,"WiFi: Could not arm the RSSI threshold at %d dBm\n", (int)threshold);
+    }
+}
+
+RoamingWiFiManager::LinkLevel RoamingWiFiManager::updateLinkLevel() {
+    portENTER_CRITICAL(&connectionMux);
+    const bool eventPending = rssiLowEventPending;
+    const int32_t eventRssi = rssiLowEventRssi;
+    rssiLowEventPending = false;
+    portEXIT_CRITICAL(&connectionMux);
+
+    bool rearm = false;
+    LinkLevel level = linkLevel;
+    if (rssiArmedBssid != connection.bssidKey) {
+        // New association (or settings): start from the current RSSI, without hysteresis; a pending event is stale
+        rssiArmedBssid = connection.bssidKey;
+        linkLevel = LinkLevel::Good;
+        level = linkLevelFor(getConnectedRssi());
+        rearm = true;
+    } else if (eventPending) {
+        rssiLowEventCount++;
+        rssiLowLastRssi = eventRssi;
+        DBG_PRINTF_L(3,"WiFi: RSSI-low event at %d dBm\n", (int)eventRssi);
+        level = linkLevelFor(eventRssi);
+        rearm = true;
+    } else if (linkLevel != LinkLevel::Good) {
+        // No event reports a recovery; getConnectedRssi() limits the polling rate
+        level = linkLevelFor(getConnectedRssi());
+    }
+    if (level != linkLevel) {
+        DBG_PRINTF_L(2,"WiFi: Link level %s -> %s (%d dBm)\n", toString(linkLevel), toString(level), (int)getConnectedRssi());
+        linkLevel = level;
+        linkLevelChangeCount++;
+        rearm = true;
+    }
+    if (rearm) {
+        armRssiThreshold();
+    }
+    return linkLevel;
+}
+
 bool RoamingWiFiManager::connectDirectSaved() {
     if (savedSSID.length() == 0) {
         return false;
@@ -499,254 +919,958 @@ void RoamingWiFiManager::persistConnectedNetwork() {
 
 
 
-void RoamingWiFiManager::copyScannedNetworksToList(bool keepExisting) {
-    int n = WiFi.scanComplete();
-    if (n < 0) {
-        DBG_PRINTLN_L(2,"WiFi: No completed scan to copy networks from.");
-        return;
-    } else {
-        DBG_PRINTF_L(3,"WiFi: Copying %d scanned networks to internal list.\n", n);
-    }
-
-    if (keepExisting) {
-        // Keep the existing list, but mark everything as not detected.
-        // Then update entries found in this scan and add any new entries.
-        for (auto& existing : scannedNetworkList) {
-            // A full scan was performed, so every cached entry was part of the last scan attempt.
-            // Even if it is not detected in this scan result, it is still considered "scanned".
-            existing.scanned = true;
-            existing.detected = false;
-            //existing.rssi = -1000;
-            existing.known = isKnownSsid(existing.ssid);
-        }
+int RoamingWiFiManager::findNetworkIndex(uint64_t bssidKey) const {
+    return scannedNetworkIndex.find(bssidKey);
+}
 
-        for (int i = 0; i < n; i++) {
-            const String bssid = WiFi.BSSIDstr(i);
-            if (bssid.length() == 0) {
-                continue;
-            }
+void RoamingWiFiManager::addNetwork(const ScannedNetwork& net) {
+    scannedNetworkList.push_back(net);
+    scannedNetworkIndex.insert(net.bssidKey(), (int32_t)(scannedNetworkList.size() - 1));
+}
 
-            int existingIndex = -1;
-            for (size_t j = 0; j < scannedNetworkList.size(); j++) {
-                if (scannedNetworkList[j].bssid.equalsIgnoreCase(bssid)) {
-                    existingIndex = (int)j;
-                    break;
-                }
-            }
+void RoamingWiFiManager::rebuildNetworkIndex() {
+    scannedNetworkIndex.clear();
+    scannedNetworkIndex.reserve(scannedNetworkList.size());
+    for (size_t i = 0; i < scannedNetworkList.size(); i++) {
+        scannedNetworkIndex.insert(scannedNetworkList[i].bssidKey(), (int32_t)i);
+    }
+}
 
-            if (existingIndex >= 0) {
-                ScannedNetwork& entry = scannedNetworkList[(size_t)existingIndex];
-                entry.ssid = WiFi.SSID(i);
-                entry.bssid = bssid;
-                entry.rssi = WiFi.RSSI(i);
-                entry.channel = WiFi.channel(i);
-                entry.encryption = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted";
-                entry.scanned = true;
-                entry.detected = true;
-                entry.known = isKnownSsid(entry.ssid);
-            } else {
-                ScannedNetwork net;
-                net.ssid = WiFi.SSID(i);
-                net.bssid = bssid;
-                net.rssi = WiFi.RSSI(i);
-                net.channel = WiFi.channel(i);
-                net.encryption = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted";
-                net.scanned = true;
-                net.detected = true;
-                net.known = isKnownSsid(net.ssid);
-                scannedNetworkList.push_back(net);
-            }
-        }
-    } else {
-        scannedNetworkList.clear();
-        for (int i = 0; i < n; i++) {
-            ScannedNetwork net;
-            net.ssid = WiFi.SSID(i);
-            net.bssid = WiFi.BSSIDstr(i);
-            net.rssi = WiFi.RSSI(i);
-            net.channel = WiFi.channel(i);
-            net.encryption = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted";
-            net.scanned = true;
-            net.detected = true;
-            net.known = isKnownSsid(net.ssid);
-            scannedNetworkList.push_back(net);
-        }
+void RoamingWiFiManager::setNetworkSsid(ScannedNetwork& entry, const char* ssid) {
+    if (strncmp(entry.ssid, ssid, sizeof(entry.ssid) - 1) == 0) {
+        return; // unchanged, credentialId is still valid
     }
-    sortNetworks();
+    strlcpy(entry.ssid, ssid, sizeof(entry.ssid));
+    entry.credentialId = (uint16_t)(knownSsids.find(entry.ssid) + 1);
+}
 
-    lastNetworksScanTime = millis();
+const wifi_ap_record_t* RoamingWiFiManager::getScanRecord(int scanIndex) {
+    return (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(scanIndex);
+}
 
-    // Free scan result memory.
-    //WiFi.scanDelete();
+void RoamingWiFiManager::updateNetworkFromRecord(ScannedNetwork& entry, const wifi_ap_record_t& rec) {
+    setNetworkSsid(entry, (const char*)rec.ssid);
+    if (entry.missPending) {
+        // A dwell missed this BSSID shortly before it was heard again: it was there all along
+        entry.missPending = 0;
+        if (adaptiveDwell && millis() - entry.lastSeenMs <= DwellFalseEmptyWindowMs) {
+            noteFalseEmpty(entry);
+        }
+    }
+    entry.channel = rec.primary;
+    entry.authMode = (uint8_t)rec.authmode;
+    updateCapabilitiesFromRecord(entry.caps, rec);
+    noteRssiSample(entry, rec.rssi);
 }
 
+void RoamingWiFiManager::updateCapabilitiesFromRecord(ApCapabilities& caps, const wifi_ap_record_t& rec) {
+    // The driver has already parsed the IEs of the scan results into the record; BSS Load and the
+    // PMF bits are not in it and only come from heard beacons (beaconHarvest), so they are kept.
+    caps.phy = (rec.phy_11n ? ApCapabilities::PhyHt : 0) | (rec.phy_11ac ? ApCapabilities::PhyVht : 0) |
+               (rec.phy_11ax ? ApCapabilities::PhyHe : 0) | (caps.phy & ApCapabilities::PhyEht);
+    switch (rec.bandwidth) {
+        case WIFI_BW_HT20: caps.widthMhz20 = 1; break;
+        case WIFI_BW_HT40: caps.widthMhz20 = 2; break;
+        case WIFI_BW80: caps.widthMhz20 = 4; break;
+        case WIFI_BW160:
+        case WIFI_BW80_BW80: caps.widthMhz20 = 8; break;
+        default: caps.widthMhz20 = (rec.second != WIFI_SECOND_CHAN_NONE) ? 2 : 1; break;
+    }
+    switch (rec.pairwise_cipher) {
+        case WIFI_CIPHER_TYPE_TKIP: caps.ciphers = ApCapabilities::CipherTkip; break;
+        case WIFI_CIPHER_TYPE_CCMP: caps.ciphers = ApCapabilities::CipherCcmp; break;
+        case WIFI_CIPHER_TYPE_TKIP_CCMP: caps.ciphers = ApCapabilities::CipherTkip | ApCapabilities::CipherCcmp; break;
+        case WIFI_CIPHER_TYPE_GCMP:
+        case WIFI_CIPHER_TYPE_GCMP256: caps.ciphers = ApCapabilities::CipherGcmp; break;
+        default: caps.ciphers = 0; break;
+    }
+    // Beacons list FT and the individual AKM suites; the auth mode only tells the family
+    const uint8_t ft = caps.akms & ApCapabilities::AkmFt;
+    switch (rec.authmode) {
+        case WIFI_AUTH_WPA_PSK:
+        case WIFI_AUTH_WPA2_PSK:
+        case WIFI_AUTH_WPA_WPA2_PSK: caps.akms = ApCapabilities::AkmPsk | ft; break;
+        case WIFI_AUTH_WPA3_PSK: caps.akms = ApCapabilities::AkmSae | ft; break;
+        case WIFI_AUTH_WPA2_WPA3_PSK: caps.akms = ApCapabilities::AkmPsk | ApCapabilities::AkmSae | ft; break;
+        case WIFI_AUTH_ENTERPRISE: caps.akms = ApCapabilities::AkmEap | ft; break;
+        case WIFI_AUTH_WPA3_ENT_192: caps.akms = ApCapabilities::AkmEap | ApCapabilities::AkmSuiteB; break;
+        case WIFI_AUTH_OWE: caps.akms = ApCapabilities::AkmOwe; break;
+        default: caps.akms = 0; break;
+    }
+}
 
+void RoamingWiFiManager::noteRssiSample(ScannedNetwork& entry, int8_t rssi) {
+    if (entry.detected) {
+        // Running mean of the RSSI change between consecutive detections (alpha = 1/4)
+        const int changeQdb = std::min(63, abs((int)rssi - (int)entry.rssi)) * 4;
+        entry.rssiVolatility = (uint8_t)((int)entry.rssiVolatility + (changeQdb - (int)entry.rssiVolatility) / 4);
+    }
+    const uint32_t now = millis();
+    if (entry.detected) {
+        entry.rssiFilter.update(rssi, now - entry.lastSeenMs);
+    } else {
+        entry.rssiFilter.reset(rssi); // a track across a miss says little
+    }
+    entry.rssi = rssi;
+    entry.scanned = true;
+    entry.detected = true;
+    entry.lastSeenMs = now;
+    scheduleRescan(entry);
+    noteNetworkChanged(entry);
+}
 
-JsonDocument RoamingWiFiManager::getScannedNetworksAsJsonDocument() {
-    JsonDocument doc; // Clear existing document
-    doc["scanAgeSec"] = (lastNetworksScanTime == 0) ? -1 : (int)((millis() - lastNetworksScanTime) / 1000);
-    doc["scanCount"] = networkScanCount;
-    doc["scanType"] = lastNetworksScanType;
-    
-    // Get currently connected network info for comparison
-    const bool isConnected = (WiFi.status() == WL_CONNECTED);
-    const String currentSsid = isConnected ? WiFi.SSID() : "";
-    const String currentBssid = isConnected ? WiFi.BSSIDstr() : "";
-    const int currentChannel = isConnected ? WiFi.channel() : 0;
-    
-    JsonArray scannedNetworks = doc["networks"].to<JsonArray>();
-    for (const auto& net : scannedNetworkList) {
-        JsonObject network = scannedNetworks.add<JsonObject>();
-        network["ssid"] = net.ssid;
-        network["bssid"] = net.bssid;
-        network["rssi"] = net.rssi;
-        network["channel"] = net.channel;
-        network["encryption"] = net.encryption;
-        network["scanned"] = net.scanned;
-        network["detected"] = net.detected;
-        network["known"] = net.known;
-        
-        // Determine if this is the currently connected network (same BSSID and channel)
-        const bool matchBssid = isConnected && net.bssid.equalsIgnoreCase(currentBssid);
-        const bool matchChannel = isConnected && (net.channel == currentChannel);
-        network["connected"] = matchBssid && matchChannel;
-        
-        // Determine if this network has the same SSID as connected but different BSSID
-        const bool sameSsid = isConnected && currentSsid.length() > 0 && net.ssid.equals(currentSsid);
-        const bool differentBssid = !net.bssid.equalsIgnoreCase(currentBssid);
-        network["sameSsidAsConnected"] = sameSsid && differentBssid;
+int RoamingWiFiManager::mergeScanRecord(const wifi_ap_record_t& rec, bool& added) {
+    const int existingIndex = findNetworkIndex(bssidToKey(rec.bssid));
+    if (existingIndex >= 0) {
+        updateNetworkFromRecord(scannedNetworkList[(size_t)existingIndex], rec);
+        added = false;
+        return existingIndex;
     }
+    ScannedNetwork net{};
+    memcpy(net.bssid, rec.bssid, sizeof(net.bssid));
+    updateNetworkFromRecord(net, rec);
+    addNetwork(net);
+    added = true;
+    return (int)scannedNetworkList.size() - 1;
+}
 
-    // Expose previously assigned client IP addresses for UI display.
-    JsonArray clientIps = doc["clientIps"].to<JsonArray>();
-    for (const auto& ip : _clientIpAddresses) {
-        if (!ip.isEmpty()) {
-            clientIps.add(ip);
+RoamingWiFiManager::UnknownAdmission RoamingWiFiManager::computeUnknownAdmission(int scanCount) const {
+    UnknownAdmission admission;
+    if (apDropUnknown) {
+        admission.none = true;
+        return admission;
+    }
+    // Histogram of unknown-SSID RSSIs in this result set (bin = -rssi, clamped to 0..128)
+    uint16_t histogram[129] = {0};
+    uint32_t unknownCount = 0;
+    for (int i = 0; i < scanCount; i++) {
+        const wifi_ap_record_t* rec = getScanRecord(i);
+        if (rec == nullptr || knownSsids.find((const char*)rec->ssid) >= 0) {
+            continue;
         }
+        const int bin = std::min(128, std::max(0, -(int)rec->rssi));
+        histogram[bin]++;
+        unknownCount++;
     }
-    return doc;
+    if (unknownCount <= apUnknownTopK) {
+        return admission; // everything fits
+    }
+    if (apUnknownTopK == 0) {
+        admission.none = true;
+        return admission;
+    }
+    uint32_t stronger = 0;
+    for (int bin = 0; bin <= 128; bin++) {
+        if (stronger + histogram[bin] >= apUnknownTopK) {
+            admission.minRssi = (int8_t)(-bin);
+            admission.atMinLeft = (uint16_t)(apUnknownTopK - stronger);
+            break;
+        }
+        stronger += histogram[bin];
+    }
+    return admission;
 }
 
-
-void RoamingWiFiManager::sortNetworks() {
-    if (scannedNetworkList.empty()) {
-        DBG_PRINTLN_L(3,"sortNetworks: No scanned networks available.");
-        return;
+bool RoamingWiFiManager::admitScanRecord(const wifi_ap_record_t& rec, UnknownAdmission& admission) {
+    if (knownSsids.find((const char*)rec.ssid) >= 0 || findNetworkIndex(bssidToKey(rec.bssid)) >= 0) {
+        return true;
     }
-    // Desired order:
-    // 1) Detected networks with same SSID as connected (including connected network), sorted by RSSI
-    // 2) Non-detected networks with same SSID as connected (sorted by RSSI)
-    // 3) Other known networks (sorted by RSSI)
-    // 4) Remaining (unknown) networks (sorted by RSSI)
-
-    const bool isConnected = (WiFi.status() == WL_CONNECTED);
-    const String currentSsid = isConnected ? WiFi.SSID() : "";
-
-    std::vector<ScannedNetwork> groupSameSsidDetected;
-    std::vector<ScannedNetwork> groupSameSsidNotDetected;
-    std::vector<ScannedNetwork> groupKnownOther;
-    std::vector<ScannedNetwork> groupUnknown;
-
-    groupSameSsidDetected.reserve(scannedNetworkList.size());
-    groupSameSsidNotDetected.reserve(scannedNetworkList.size());
-    groupKnownOther.reserve(scannedNetworkList.size());
-    groupUnknown.reserve(scannedNetworkList.size());
+    const int8_t rssi = (int8_t)std::max(-128, (int)rec.rssi);
+    if (admission.none || rssi < admission.minRssi) {
+        return false;
+    }
+    if (rssi == admission.minRssi) {
+        if (admission.atMinLeft == 0) {
+            return false;
+        }
+        admission.atMinLeft--;
+    }
+    return true;
+}
 
-    for (const auto& net : scannedNetworkList) {
-        // Check if same SSID as connected (including the connected network itself)
-        const bool sameSsid = isConnected && currentSsid.length() > 0 && net.ssid.equals(currentSsid);
-        if (sameSsid) {
-            if (net.detected) {
-                groupSameSsidDetected.push_back(net);
-            } else {
-                groupSameSsidNotDetected.push_back(net);
-            }
+int RoamingWiFiManager::mergeChannelScanResults(int scanCount) {
+    UnknownAdmission admission = computeUnknownAdmission(scanCount);
+    int discovered = 0;
+    for (int i = 0; i < scanCount; i++) {
+        const wifi_ap_record_t* rec = getScanRecord(i);
+        if (rec == nullptr) {
             continue;
         }
-
-        // Check if it's a known network (different SSID from connected)
-        bool isKnown = false;
-        for (const NetworkCredentials& known : knownNetworks) {
-            if (net.ssid.equals(known.ssid)) {
-                isKnown = true;
-                break;
-            }
+        if (!admitScanRecord(*rec, admission)) {
+            apIngestSkippedCount++;
+            continue;
+        }
+        const int existingIndex = findNetworkIndex(bssidToKey(rec->bssid));
+        if (existingIndex < 0 || !scannedNetworkList[(size_t)existingIndex].detected) {
+            discovered++;
         }
-        if (isKnown) {
-            groupKnownOther.push_back(net);
+        bool added;
+        const ScannedNetwork& entry = scannedNetworkList[(size_t)mergeScanRecord(*rec, added)];
+        if (added) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan channel scan: found new network %s on channel %u\n", entry.bssidStr().c_str(), (unsigned)entry.channel);
         } else {
-            groupUnknown.push_back(net);
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan channel scan: updated %s RSSI=%d ch=%u\n", entry.bssidStr().c_str(), (int)entry.rssi, (unsigned)entry.channel);
         }
     }
-
-    auto rssiDesc = [](const ScannedNetwork& a, const ScannedNetwork& b) {
-        return a.rssi > b.rssi;
-    };
-
-    std::sort(groupSameSsidDetected.begin(), groupSameSsidDetected.end(), rssiDesc);
-    std::sort(groupSameSsidNotDetected.begin(), groupSameSsidNotDetected.end(), rssiDesc);
-    std::sort(groupKnownOther.begin(), groupKnownOther.end(), rssiDesc);
-    std::sort(groupUnknown.begin(), groupUnknown.end(), rssiDesc);
-
-    scannedNetworkList.clear();
-    scannedNetworkList.reserve(groupSameSsidDetected.size() + groupSameSsidNotDetected.size() + 
-                                groupKnownOther.size() + groupUnknown.size());
-    scannedNetworkList.insert(scannedNetworkList.end(), groupSameSsidDetected.begin(), groupSameSsidDetected.end());
-    scannedNetworkList.insert(scannedNetworkList.end(), groupSameSsidNotDetected.begin(), groupSameSsidNotDetected.end());
-    scannedNetworkList.insert(scannedNetworkList.end(), groupKnownOther.begin(), groupKnownOther.end());
-    scannedNetworkList.insert(scannedNetworkList.end(), groupUnknown.begin(), groupUnknown.end());
+    return discovered;
 }
 
+int RoamingWiFiManager::selectTestChannel() {
+    if (testChannelStats.size() != autoRescanTestChannelList.size()) {
+        testChannelStats.assign(autoRescanTestChannelList.size(), TestChannelStats{});
+    }
+    // Explore: the least recently tested channel, so channels without a yield yet are still visited
+    const bool explore = (esp_random() % 1000) < (uint32_t)(testChannelExploreRate * 1000.0f);
+    int best = 0;
+    for (int i = 1; i < (int)testChannelStats.size(); i++) {
+        const TestChannelStats& a = testChannelStats[(size_t)i];
+        const TestChannelStats& b = testChannelStats[(size_t)best];
+        // Exploit: the highest expected yield; ties (e.g., all zero after a cold start) go round-robin
+        if ((!explore && a.yieldQ8 > b.yieldQ8) ||
+            ((explore || a.yieldQ8 == b.yieldQ8) && a.lastTestSeq < b.lastTestSeq)) {
+            best = i;
+        }
+    }
+    DBG_PRINTF_L(4,"WiFi: Test channel %d selected (%s, yield %.2f)\n", autoRescanTestChannelList[(size_t)best],
+        explore ? "explore" : "best yield", (double)(testChannelStats[(size_t)best].yieldQ8 / 256.0f));
+    return best;
+}
 
-
-void RoamingWiFiManager::printNetworks() {
-    if (scannedNetworkList.empty()) {
-        DBG_PRINTLN_L(1,"printNetworks: No scanned networks available.");
+void RoamingWiFiManager::recordTestChannelYield(int listIndex, int discovered) {
+    if (listIndex < 0 || (size_t)listIndex >= testChannelStats.size()) {
         return;
     }
+    TestChannelStats& stats = testChannelStats[(size_t)listIndex];
+    const int sample = std::min(discovered, 255) * 256;
+    stats.yieldQ8 = (uint16_t)((int)stats.yieldQ8 + (sample - (int)stats.yieldQ8) / 8);
+    if (stats.scans < 0xFFFF) {
+        stats.scans++;
+    }
+    stats.discovered += (uint32_t)discovered;
+    stats.lastTestSeq = ++testChannelSeq;
+    if (millis() - testChannelStatsSavedTime >= TestChannelStatsSaveIntervalMs) {
+        saveTestChannelStats();
+    }
+}
 
-    DBG_PRINTLN_L(1,"WiFi networks:");
-    for (const auto& net : scannedNetworkList) {
-        DBG_PRINTF_L(1,"SSID: %s, BSSID: %s, RSSI: %d, Channel: %d, %s\n",
-                      net.ssid.c_str(),
-                      net.bssid.c_str(),
-                      net.rssi,
-                      net.channel,
-                      net.encryption.c_str());
+void RoamingWiFiManager::noteNetworkChanged(const ScannedNetwork& entry) {
+    if (entry.isKnown()) {
+        roamCandidates.update(entry.credentialIndex(), entry.bssidKey(), entry.radioKey(), entry.smoothedRssi(),
+                              scoreNetwork(entry, entry.smoothedRssi()).total, entry.detected && entry.scanned);
     }
 }
 
-// Returns a ScannedNetwork struct if a suitable network is found
-// If no network is found, an empty struct is returned.
-ScannedNetwork RoamingWiFiManager::findBestNetworkVar() {
-    int bestRSSI = -1000;
-    String bestSSID = "";
-    
-    ScannedNetwork bestNetworkVar;
-    
-    // Find the strongest known network from cached data
-    for (const auto& net : scannedNetworkList) {
-        String scannedSSID = net.ssid;
-        int rssi = net.rssi;
-        if (!net.detected) {
-            continue; // Skip networks not detected in the last scan
-        }
-        if (!net.known) {
-            continue; // Skip unknown networks
-        }
-        
-        if (rssi > bestRSSI) {
-            bestRSSI = rssi;
-            bestSSID = scannedSSID;
-            bestNetworkVar = net;
-        }
+ApScore RoamingWiFiManager::scoreNetwork(const ScannedNetwork& net, int8_t rssi) const {
+    ApScoreInput in;
+    in.rssi = rssi;
+    in.channel = net.channel;
+    in.caps = net.caps;
+    in.connectFailures = connectFailureCount(net.bssidKey());
+    in.dfsPenaltyDb = (uint8_t)scoreDfsPenaltyDb;
+    in.failPenaltyDb = (uint8_t)scoreFailPenaltyDb;
+    if (customScoreFunction != nullptr) {
+        return customScoreFunction(in);
     }
-    return bestNetworkVar;    
+    return autoRoamScoring ? ApScoring::multiFactor(in) : ApScoring::rssiOnly(in);
 }
 
+const char* RoamingWiFiManager::scoreFunctionName() const {
+    if (customScoreFunction != nullptr) return "custom";
+    return autoRoamScoring ? "multiFactor" : "rssiOnly";
+}
 
-void RoamingWiFiManager::connectToStrongestNetwork() {
-    DBG_PRINTLN_L(2,"WiFi: Connecting to strongest known network using cached data...");
+uint8_t RoamingWiFiManager::connectFailureCount(uint64_t bssidKey) const {
+    for (const auto& failure : connectFailures) {
+        if (failure.count != 0 && failure.bssidKey == bssidKey) {
+            return failure.count;
+        }
+    }
+    return 0;
+}
+
+void RoamingWiFiManager::noteConnectFailure(uint64_t bssidKey, uint32_t nowMs) {
+    if (bssidKey == 0) {
+        return;
+    }
+    // Same BSSID, else a free slot, else the oldest failure makes room
+    ConnectFailure* slot = nullptr;
+    for (auto& failure : connectFailures) {
+        if (failure.count != 0 && failure.bssidKey == bssidKey) {
+            slot = &failure;
+            break;
+        }
+        if (slot == nullptr || (slot->count != 0 && (failure.count == 0 || failure.timeMs - slot->timeMs > 0x80000000u))) {
+            slot = &failure;
+        }
+    }
+    if (slot->bssidKey != bssidKey) {
+        slot->bssidKey = bssidKey;
+        slot->count = 0;
+    }
+    if (slot->count < 255) {
+        slot->count++;
+    }
+    slot->timeMs = nowMs;
+    DBG_PRINTF_L(2,"WiFi: Connect to %s failed (%u recent failures)\n", BssidStr(bssidKey).c_str(), (unsigned)slot->count);
+    rescoreNetwork(bssidKey);
+}
+
+void RoamingWiFiManager::handleConnectFailures() {
+    const uint32_t now = millis();
+    portENTER_CRITICAL(&connectionMux);
+    const bool failed = connectFailEventPending;
+    const uint64_t failedBssid = connectFailEventBssid;
+    connectFailEventPending = false;
+    portEXIT_CRITICAL(&connectionMux);
+    if (failed) {
+        noteConnectFailure(failedBssid, now);
+    }
+    for (auto& failure : connectFailures) {
+        if (failure.count == 0) {
+            continue;
+        }
+        const bool recovered = connection.connected && connection.bssidKey == failure.bssidKey;
+        if (recovered || now - failure.timeMs > ConnectFailureMemoryMs) {
+            failure.count = 0;
+            rescoreNetwork(failure.bssidKey);
+        }
+    }
+}
+
+void RoamingWiFiManager::rescoreNetwork(uint64_t bssidKey) {
+    const int pos = findNetworkIndex(bssidKey);
+    if (pos >= 0) {
+        noteNetworkChanged(scannedNetworkList[(size_t)pos]);
+    }
+}
+
+void RoamingWiFiManager::refreshRadioMembers(const ScannedNetwork& source) {
+    const uint64_t radio = source.radioKey();
+    const uint64_t sourceBssid = source.bssidKey();
+    for (auto& member : scannedNetworkList) {
+        if (member.radioKey() != radio || member.bssidKey() == sourceBssid) {
+            continue;
+        }
+        member.rssi = source.rssi;
+        member.rssiFilter = source.rssiFilter;
+        member.scanned = true;
+        member.detected = true;
+        member.lastSeenMs = source.lastSeenMs;
+        member.sweepRefreshed = 1;
+        scheduleRescan(member);
+        noteNetworkChanged(member);
+        DBG_PRINTF_L(4,"WiFi: Auto-rescan: %s refreshed via same radio as %s\n", member.bssidStr().c_str(), source.bssidStr().c_str());
+    }
+}
+
+void RoamingWiFiManager::refreshRoamCandidates() {
+    if (roamScoringChanged) {
+        roamScoringChanged = false;
+        roamCandidates.markAllDirty(); // ranked again with the new scoring
+    }
+    if (!roamCandidates.needsRebuild()) {
+        return;
+    }
+    roamCandidates.beginRebuild();
+    for (const auto& net : scannedNetworkList) {
+        if (net.isKnown() && roamCandidates.isDirty(net.credentialIndex())) {
+            noteNetworkChanged(net);
+        }
+    }
+    roamCandidates.endRebuild();
+}
+
+uint64_t RoamingWiFiManager::getConnectedBssidKey() const {
+    return connection.connected ? connection.bssidKey : 0;
+}
+
+int8_t RoamingWiFiManager::getConnectedRssi() {
+    if (!connection.connected) {
+        return 0;
+    }
+    if (connection.rssiTimeMs == 0 || millis() - connection.rssiTimeMs >= ConnectionRssiMaxAgeMs) {
+        sampleConnectedRssi(false);
+    }
+    return connection.rssi;
+}
+
+void RoamingWiFiManager::sampleConnectedRssi(bool record) {
+    // Beacon RSSI the driver keeps for the serving AP; unlike WiFi.RSSI() this does not copy the whole AP record
+    int rssi = 0;
+    if (esp_wifi_sta_get_rssi(&rssi) != ESP_OK || rssi == 0) {
+        return;
+    }
+    const uint32_t now = millis();
+    connection.rssi = (int8_t)rssi;
+    connection.rssiTimeMs = now;
+    if (!record) {
+        return;
+    }
+    connectedRssiSampleTimeMs = now;
+    connectedRssiTrace[connectedRssiTraceCount % ConnectedRssiTraceSize] = RssiSample{now, (int8_t)rssi};
+    connectedRssiTraceCount++;
+
+    // The table entry is then as fresh as the value roaming compares candidates against
+    const int pos = findNetworkIndex(connection.bssidKey);
+    if (pos >= 0) {
+        noteRssiSample(scannedNetworkList[(size_t)pos], (int8_t)rssi);
+    }
+}
+
+void RoamingWiFiManager::applyBeaconHarvest() {
+    if (beaconHarvest == promiscuousActive) {
+        return;
+    }
+    if (!beaconHarvest) {
+        esp_wifi_set_promiscuous(false);
+        promiscuousActive = false;
+        DBG_PRINTLN_L(2,"WiFi: Beacon harvesting stopped.");
+        return;
+    }
+    promiscuousOwner = this;
+    // Data and control frames only feed the utilisation estimate; beacons come with the management frames
+    wifi_promiscuous_filter_t filter = {};
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_CTRL | WIFI_PROMIS_FILTER_MASK_DATA;
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(&RoamingWiFiManager::handlePromiscuousPacket);
+    if (esp_wifi_set_promiscuous(true) != ESP_OK) {
+        DBG_PRINTLN_L(1,"WiFi: Could not enable promiscuous mode for beacon harvesting.");
+        return;
+    }
+    promiscuousActive = true;
+    harvestWindowStart = 0;
+    DBG_PRINTLN_L(2,"WiFi: Beacon harvesting started.");
+}
+
+// Coded as in wifi_phy_rate_t (and the L-SIG RATE field): 0x08 = 48M, 0x09 = 24M, ... 0x0F = 9M
+uint32_t RoamingWiFiManager::legacyRateKbps(unsigned rate) {
+    static const uint32_t ofdmKbps[8] = {48000, 24000, 12000, 6000, 54000, 36000, 18000, 9000};
+    static const uint32_t dsssKbps[8] = {1000, 2000, 5500, 11000, 2000, 2000, 5500, 11000}; // long, short preamble
+    return (rate >= 0x08 && rate <= 0x0F) ? ofdmKbps[rate - 0x08] : dsssKbps[rate & 0x07];
+}
+
+uint32_t RoamingWiFiManager::htRateKbps(unsigned mcs, unsigned streams, unsigned bandwidth) {
+    // Per spatial stream at 20 MHz with the long guard interval; 40/80/160 MHz carry 108/52, 234/52 and 468/52 times as much
+    static const uint32_t mcsKbps[10] = {6500, 13000, 19500, 26000, 39000, 52000, 58500, 65000, 78000, 86700};
+    static const uint32_t subcarriers[4] = {52, 108, 234, 468};
+    return mcsKbps[mcs < 10 ? mcs : 9] * streams * subcarriers[bandwidth & 0x03] / 52;
+}
+
+#if SOC_WIFI_HE_SUPPORT
+// esp_wifi_rxctrl_t (ESP32-C5 and other HE targets): cur_bb_format is a wifi_rx_bb_format_t, rate is the
+// L-SIG rate of legacy frames, and he_siga1/he_siga2 hold the HT-SIG, VHT-SIG-A or HE-SIG-A of the rest.
+uint32_t RoamingWiFiManager::rxRateKbps(const wifi_pkt_rx_ctrl_t& rx, bool& htPreamble) {
+    enum : unsigned { Format11b = 0, Format11g = 1, FormatHt = 2, FormatVht = 3, FormatHeSu = 4, FormatHeMu = 5, FormatHeErSu = 6, FormatHeTb = 7 };
+    // HE rates per spatial stream at 20 MHz with the 0.8 us guard interval; a doubled width about doubles them
+    static const uint32_t heMcsKbps[12] = {8600, 17200, 25800, 34400, 51600, 68800, 77400, 86000, 103200, 114700, 129000, 143400};
+    const unsigned format = rx.cur_bb_format;
+    htPreamble = format != Format11b && format != Format11g;
+    switch (format) {
+        case Format11b:
+        case Format11g:
+            return legacyRateKbps(rx.rate);
+        case FormatHt: {
+            // HT-SIG1: MCS in bits 0..6 (8 per spatial stream), CBW 20/40 in bit 7
+            const unsigned mcs = rx.he_siga1 & 0x7F;
+            return htRateKbps(mcs % 8, mcs / 8 + 1, (rx.he_siga1 >> 7) & 0x01);
+        }
+        case FormatVht: {
+            // VHT-SIG-A1: BW in bits 0..1; VHT-SIG-A2: SU MCS in bits 4..7
+            return htRateKbps((rx.he_siga2 >> 4) & 0x0F, 1, rx.he_siga1 & 0x03);
+        }
+        case FormatHeSu:
+        case FormatHeErSu: {
+            // HE-SIG-A1 (SU): MCS in bits 3..6, bandwidth in bits 19..20 (ER SU is 20 MHz at most)
+            const unsigned mcs = (rx.he_siga1 >> 3) & 0x0F;
+            const unsigned bandwidth = (format == FormatHeSu) ? (rx.he_siga1 >> 19) & 0x03 : 0;
+            return heMcsKbps[mcs < 12 ? mcs : 11] << bandwidth;
+        }
+        case FormatHeMu:
+        case FormatHeTb:
+        default:
+            // Per-user rates are not in the common fields: assume the lowest, so busy time errs high
+            return heMcsKbps[0];
+    }
+}
+#else
+// wifi_pkt_rx_ctrl_t of the targets without HE: sig_mode 0 = legacy, 1 = HT, 3 = VHT
+uint32_t RoamingWiFiManager::rxRateKbps(const wifi_pkt_rx_ctrl_t& rx, bool& htPreamble) {
+    htPreamble = rx.sig_mode != 0;
+    if (rx.sig_mode == 0) {
+        return legacyRateKbps(rx.rate);
+    }
+    if (rx.sig_mode == 1) {
+        return htRateKbps(rx.mcs % 8, rx.mcs / 8 + 1, rx.cwb);
+    }
+    return htRateKbps(rx.mcs % 10, 1, rx.cwb);
+}
+#endif
+
+void RoamingWiFiManager::handlePromiscuousPacket(void* buf, wifi_promiscuous_pkt_type_t type) {
+    RoamingWiFiManager* self = promiscuousOwner;
+    if (self == nullptr || buf == nullptr) {
+        return;
+    }
+    const wifi_promiscuous_pkt_t* pkt = static_cast<const wifi_promiscuous_pkt_t*>(buf);
+    const wifi_pkt_rx_ctrl_t& rx = pkt->rx_ctrl;
+    const size_t len = (rx.sig_len > 4) ? (size_t)rx.sig_len - 4 : 0; // sig_len includes the FCS
+    bool htPreamble = false;
+    const uint32_t rateKbps = rxRateKbps(rx, htPreamble);
+    self->harvester.noteFrame(BeaconHarvester::estimateAirtimeUs(rx.sig_len, rateKbps, htPreamble));
+    if (type != WIFI_PKT_MGMT) {
+        return;
+    }
+    BeaconInfo info;
+    if (!BeaconParser::parse(pkt->payload, len, info)) {
+        return;
+    }
+    BeaconHarvester::Sample sample;
+    sample.bssidKey = bssidToKey(info.bssid);
+    sample.timeMs = millis();
+    sample.rssi = (int8_t)rx.rssi;
+    // Without a channel element the frame was heard where the radio is; off the home channel (during a
+    // scan) that sample can only be dropped by the loop's channel check, never misattributed
+    sample.channel = (info.channel != 0) ? info.channel : self->harvester.currentHomeChannel();
+    sample.caps = info.caps;
+    self->harvester.push(sample);
+}
+
+void RoamingWiFiManager::handleBeaconHarvest() {
+    if (!promiscuousActive) {
+        return;
+    }
+    harvester.setHomeChannel(connection.connected ? connection.channel : 0);
+
+    // Only entries the scans already know are refreshed; beacons also arrive from the channels being scanned
+    BeaconHarvester::Sample sample;
+    while (harvester.pop(sample)) {
+        const int pos = findNetworkIndex(sample.bssidKey);
+        if (pos < 0 || scannedNetworkList[(size_t)pos].channel != sample.channel) {
+            continue;
+        }
+        ScannedNetwork& entry = scannedNetworkList[(size_t)pos];
+        entry.caps = sample.caps;
+        noteRssiSample(entry, sample.rssi);
+        harvestUpdateCount++;
+    }
+
+    // Channel utilisation: airtime of the home-channel frames per window the radio stayed home
+    if (scanInProgress) {
+        harvestWindowScanned = true;
+    }
+    const unsigned long now = millis();
+    if (harvestWindowStart == 0 || now - harvestWindowStart >= HarvestWindowMs) {
+        const uint32_t busyUs = harvester.takeBusyUs();
+        if (harvestWindowStart != 0 && !harvestWindowScanned && connection.connected) {
+            const float percent = std::min(100.0f, (float)busyUs / (float)(now - harvestWindowStart) / 10.0f);
+            channelUtilisationPercent = percent;
+            channelUtilisationAvgPercent = (channelUtilisationAvgPercent < 0.0f) ? percent :
+                channelUtilisationAvgPercent + (percent - channelUtilisationAvgPercent) / 8.0f;
+        }
+        harvestWindowStart = now;
+        harvestWindowScanned = scanInProgress;
+    }
+}
+
+void RoamingWiFiManager::handleConnectedRssiSampling() {
+    if (connectedRssiSampleMs == 0 || !connection.connected) {
+        return;
+    }
+    // Own timestamp: getConnectedRssi() refreshes connection.rssi more often without recording
+    if (connectedRssiSampleTimeMs == 0 || millis() - connectedRssiSampleTimeMs >= connectedRssiSampleMs) {
+        sampleConnectedRssi(true);
+    }
+}
+
+void RoamingWiFiManager::enforceApTableLimits() {
+    const uint32_t now = millis();
+    const uint64_t connectedBssid = getConnectedBssidKey();
+    const uint32_t maxAgeMs = (uint32_t)(apTableMaxAgeSec * 1000.0f);
+    size_t remaining = scannedNetworkList.size();
+    size_t evictedAge = 0;
+
+    // Marks the count entries of evictionCandidates that come first under worse() for eviction. One selection
+    // per step instead of a search of the whole table per victim; equal entries go in table order.
+    auto evictWorst = [this](size_t count, auto worse) -> size_t {
+        count = std::min(count, evictionCandidates.size());
+        if (count == 0) {
+            return 0;
+        }
+        auto before = [this, &worse](uint32_t a, uint32_t b) {
+            const ScannedNetwork& netA = scannedNetworkList[a];
+            const ScannedNetwork& netB = scannedNetworkList[b];
+            return worse(netA, netB) || (!worse(netB, netA) && a < b);
+        };
+        if (count < evictionCandidates.size()) {
+            std::nth_element(evictionCandidates.begin(), evictionCandidates.begin() + (long)(count - 1), evictionCandidates.end(), before);
+        }
+        for (size_t i = 0; i < count; i++) {
+            scannedNetworkList[evictionCandidates[i]].evictPending = 1;
+        }
+        return count;
+    };
+
+    // 1) Age: drop entries that have not been detected for too long
+    for (auto& net : scannedNetworkList) {
+        net.evictPending = 0;
+        if (maxAgeMs != 0 && !net.detected && net.bssidKey() != connectedBssid && now - net.lastSeenMs > maxAgeMs) {
+            net.evictPending = 1;
+            evictedAge++;
+            remaining--;
+        }
+    }
+
+    // 2) Policy: keep at most apUnknownTopK unknown entries (none if apDropUnknown);
+    //    drop undetected ones first, then the weakest, then the least recently seen
+    size_t evictedPolicy = 0;
+    {
+        const size_t unknownLimit = apDropUnknown ? 0 : apUnknownTopK;
+        evictionCandidates.clear();
+        for (size_t i = 0; i < scannedNetworkList.size(); i++) {
+            const ScannedNetwork& net = scannedNetworkList[i];
+            if (!net.evictPending && !net.isKnown() && net.bssidKey() != connectedBssid) {
+                evictionCandidates.push_back((uint32_t)i);
+            }
+        }
+        if (evictionCandidates.size() > unknownLimit) {
+            evictedPolicy = evictWorst(evictionCandidates.size() - unknownLimit, [now](const ScannedNetwork& a, const ScannedNetwork& b) {
+                if (a.detected != b.detected) {
+                    return !a.detected;
+                }
+                if (a.rssi != b.rssi) {
+                    return a.rssi < b.rssi;
+                }
+                return now - a.lastSeenMs > now - b.lastSeenMs;
+            });
+            remaining -= evictedPolicy;
+        }
+    }
+
+    // 3) Capacity: drop the least useful entries: unknown before known,
+    //    undetected before detected, then least recently seen
+    size_t evictedCap = 0;
+    if (remaining > apTableCapacity) {
+        evictionCandidates.clear();
+        for (size_t i = 0; i < scannedNetworkList.size(); i++) {
+            const ScannedNetwork& net = scannedNetworkList[i];
+            if (!net.evictPending && net.bssidKey() != connectedBssid) {
+                evictionCandidates.push_back((uint32_t)i);
+            }
+        }
+        evictedCap = evictWorst(remaining - apTableCapacity, [now](const ScannedNetwork& a, const ScannedNetwork& b) {
+            if (a.isKnown() != b.isKnown()) {
+                return !a.isKnown();
+            }
+            if (a.detected != b.detected) {
+                return !a.detected;
+            }
+            return now - a.lastSeenMs > now - b.lastSeenMs;
+        });
+        remaining -= evictedCap;
+    }
+
+    if (evictedAge == 0 && evictedPolicy == 0 && evictedCap == 0) {
+        return;
+    }
+
+    // Keep autoRescanIndex pointing at the same entry (or the same sweep position)
+    size_t evictedBeforeRescanIndex = 0;
+    for (size_t i = 0; i < autoRescanIndex && i < scannedNetworkList.size(); i++) {
+        if (scannedNetworkList[i].evictPending) {
+            evictedBeforeRescanIndex++;
+        }
+    }
+    autoRescanIndex = std::min(autoRescanIndex, scannedNetworkList.size()) - evictedBeforeRescanIndex;
+
+    scannedNetworkList.erase(std::remove_if(scannedNetworkList.begin(), scannedNetworkList.end(),
+        [](const ScannedNetwork& net) { return net.evictPending != 0; }), scannedNetworkList.end());
+    rebuildNetworkIndex();
+    roamCandidates.markAllDirty();
+
+    apTableEvictedAgeCount += evictedAge;
+    apTableEvictedCapacityCount += evictedCap;
+    apTableEvictedPolicyCount += evictedPolicy;
+    DBG_PRINTF_L(3,"WiFi: AP table evicted %u aged, %u unknown by policy and %u over capacity, %u entries left\n",
+        (unsigned)evictedAge, (unsigned)evictedPolicy, (unsigned)evictedCap, (unsigned)scannedNetworkList.size());
+}
+
+void RoamingWiFiManager::copyScannedNetworksToList(bool keepExisting) {
+    int n = WiFi.scanComplete();
+    if (n < 0) {
+        DBG_PRINTLN_L(2,"WiFi: No completed scan to copy networks from.");
+        return;
+    } else {
+        DBG_PRINTF_L(3,"WiFi: Copying %d scanned networks to internal list.\n", n);
+    }
+
+    const uint32_t mergeStartMs = millis();
+    if (keepExisting) {
+        // Keep the existing list; entries found in this scan are updated and new ones added below.
+        // Entries not heard are marked as not detected only after the merge, so the ones that were
+        // heard keep their RSSI filter track and volatility (noteRssiSample() needs the prior state).
+        roamCandidates.markAllDirty();
+    } else {
+        scannedNetworkList.clear();
+        scannedNetworkIndex.clear();
+        roamCandidates.markAllDirty();
+    }
+
+    // Update entries found in this scan and add any new entries
+    scannedNetworkList.reserve(scannedNetworkList.size() + (size_t)n); // at most one reallocation
+    UnknownAdmission admission = computeUnknownAdmission(n);
+    for (int i = 0; i < n; i++) {
+        const wifi_ap_record_t* rec = getScanRecord(i);
+        if (rec == nullptr) {
+            continue;
+        }
+        if (!admitScanRecord(*rec, admission)) {
+            apIngestSkippedCount++;
+            continue;
+        }
+        bool added;
+        mergeScanRecord(*rec, added);
+    }
+    if (keepExisting) {
+        for (auto& existing : scannedNetworkList) {
+            // A full scan was performed, so every cached entry was part of the last scan attempt.
+            // Even if it is not detected in this scan result, it is still considered "scanned".
+            existing.scanned = true;
+            if ((int32_t)(existing.lastSeenMs - mergeStartMs) < 0) {
+                existing.detected = false;
+            }
+        }
+    }
+    enforceApTableLimits();
+    sortNetworks();
+
+    lastNetworksScanTime = millis();
+
+    // Free scan result memory.
+    //WiFi.scanDelete();
+}
+
+
+
+JsonDocument RoamingWiFiManager::getScannedNetworksAsJsonDocument() {
+    JsonDocument doc; // Clear existing document
+    doc["scanAgeSec"] = (lastNetworksScanTime == 0) ? -1 : (int)((millis() - lastNetworksScanTime) / 1000);
+    doc["scanCount"] = networkScanCount;
+    doc["scanType"] = lastNetworksScanType;
+
+    // Progress of the running full scan; a chunked one has already merged channelsDone channels into the list
+    JsonObject progress = doc["fullScanProgress"].to<JsonObject>();
+    const bool burstRunning = scanInProgress && runningScanJob.channel == 0;
+    progress["active"] = fullScanChunkActive || burstRunning;
+    progress["progressive"] = fullScanChunkActive;
+    progress["purpose"] = toString(fullScanChunkActive ? fullScanChunkPurpose : (burstRunning ? scanPurpose : ScanPurpose::None));
+    progress["channelsDone"] = fullScanChunkActive ? (uint32_t)fullScanChunkNext : 0;
+    progress["channelsTotal"] = (uint32_t)autoRescanTestChannelList.size();
+    progress["channel"] = fullScanChunkActive ? autoRescanTestChannelList[fullScanChunkNext] : 0;
+    progress["directed"] = fullScanChunkActive && fullScanChunkDirected;
+    progress["records"] = fullScanChunkActive ? fullScanChunkRecords : 0;
+    progress["lastRecords"] = lastFullScanRecords; // records of the last complete chunked full scan
+    if (fullScanChunkActive || burstRunning) {
+        progress["elapsedMs"] = (uint32_t)(millis() - (fullScanChunkActive ? fullScanChunkStartTime : lastScanStartTime));
+    }
+
+    // Rescan sweep metrics per sweep mode
+    JsonObject sweeps = doc["rescanSweeps"].to<JsonObject>();
+    const char* sweepModeNames[2] = {"perBssid", "perChannel"};
+    for (int mode = 0; mode < 2; mode++) {
+        const RescanSweepStats& stats = rescanSweepStats[mode];
+        JsonObject s = sweeps[sweepModeNames[mode]].to<JsonObject>();
+        s["sweeps"] = stats.sweeps;
+        s["lastDurationMs"] = stats.lastDurationMs;
+        s["lastRadioMs"] = stats.lastRadioMs;
+        s["lastScans"] = stats.lastScans;
+        s["avgDurationMs"] = stats.avgDurationMs;
+        s["avgRadioMs"] = stats.avgRadioMs;
+    }
+
+    // Learned dwell times, per channel that had single-channel rescans
+    JsonArray dwells = doc["channelDwell"].to<JsonArray>();
+    for (size_t i = 0; i < channelDwell.size(); i++) {
+        const ChannelDwell::Stats& stats = channelDwell[i];
+        JsonObject d = dwells.add<JsonObject>();
+        d["channel"] = stats.channel;
+        d["dwellMs"] = stats.dwellMs;
+        d["hitDwellMs"] = stats.hitDwellMs;
+        d["hits"] = stats.hits;
+        d["empties"] = stats.empties;
+        d["falseEmpties"] = stats.falseEmpties;
+    }
+
+    // Discovery statistics of the test channels
+    JsonArray testChannels = doc["testChannels"].to<JsonArray>();
+    for (size_t i = 0; i < testChannelStats.size() && i < autoRescanTestChannelList.size(); i++) {
+        const TestChannelStats& stats = testChannelStats[i];
+        JsonObject t = testChannels.add<JsonObject>();
+        t["channel"] = autoRescanTestChannelList[i];
+        t["yield"] = stats.yieldQ8 / 256.0f;
+        t["scans"] = stats.scans;
+        t["discovered"] = stats.discovered;
+    }
+    
+    // Get currently connected network info for comparison
+    const bool isConnected = connection.connected;
+    const char* currentSsid = connection.ssid;
+    const uint64_t currentBssid = getConnectedBssidKey();
+    const int currentChannel = connection.channel;
+    
+    doc["scoring"] = scoreFunctionName();
+    JsonArray scannedNetworks = doc["networks"].to<JsonArray>();
+    for (const auto& net : scannedNetworkList) {
+        JsonObject network = scannedNetworks.add<JsonObject>();
+        char bssidStr[18];
+        bssidKeyToChars(net.bssidKey(), bssidStr);
+        network["ssid"] = (const char*)net.ssid;
+        network["bssid"] = bssidStr;
+        network["rssi"] = net.rssi;
+        network["rssiFiltered"] = net.rssiFilter.empty() ? (float)net.rssi : net.rssiFilter.level();
+        network["rssiSlopeDbPerSec"] = net.rssiFilter.slopeDbPerSec();
+        network["rssiStdDevDb"] = net.rssiFilter.stdDevDb();
+        network["channel"] = net.channel;
+        network["encryption"] = net.encryptionStr();
+        network["scanned"] = net.scanned;
+        network["detected"] = net.detected;
+        network["known"] = net.isKnown();
+        network["seenAgeSec"] = (int)((millis() - net.lastSeenMs) / 1000);
+        network["nextRescanSec"] = (int32_t)(net.nextRescanMs - millis()) / 1000; // negative = overdue
+        network["rssiVolatilityDb"] = net.rssiVolatility / 4.0f;
+        network["falseEmpties"] = net.falseEmpties;
+        char akms[32];
+        network["phy"] = net.caps.phyName();
+        network["widthMhz"] = net.caps.widthMhz();
+        network["akm"] = net.caps.akmNames(akms, sizeof(akms));
+        if (net.caps.flags & ApCapabilities::FlagFromBeacon) {
+            network["pmf"] = (net.caps.flags & ApCapabilities::FlagPmfRequired) ? "required" :
+                             (net.caps.flags & ApCapabilities::FlagPmfCapable) ? "capable" : "none";
+        }
+        if (net.caps.flags & ApCapabilities::FlagBssLoad) {
+            network["bssLoadStations"] = net.caps.bssLoadStations;
+            network["bssLoadPercent"] = net.caps.bssLoadPercent();
+        }
+        const ApScore score = scoreNetwork(net, net.smoothedRssi());
+        JsonObject scoreParts = network["score"].to<JsonObject>();
+        scoreParts["total"] = score.total;
+        scoreParts["rssi"] = score.rssi;
+        scoreParts["rate"] = score.rate;
+        scoreParts["estRateMbps"] = score.estRateMbps;
+        scoreParts["load"] = score.load;
+        scoreParts["dfs"] = score.dfs;
+        scoreParts["failures"] = score.failures;
+        
+        // Determine if this is the currently connected network (same BSSID and channel)
+        const bool matchBssid = isConnected && net.bssidKey() == currentBssid;
+        const bool matchChannel = isConnected && (net.channel == currentChannel);
+        network["connected"] = matchBssid && matchChannel;
+        
+        // Determine if this network has the same SSID as connected but different BSSID
+        const bool sameSsid = isConnected && currentSsid[0] != '\0' && strcmp(net.ssid, currentSsid) == 0;
+        const bool differentBssid = net.bssidKey() != currentBssid;
+        network["sameSsidAsConnected"] = sameSsid && differentBssid;
+    }
+
+    // Expose previously assigned client IP addresses for UI display.
+    JsonArray clientIps = doc["clientIps"].to<JsonArray>();
+    for (const auto& ip : _clientIpAddresses) {
+        if (!ip.isEmpty()) {
+            clientIps.add(ip);
+        }
+    }
+    return doc;
+}
+
+
+void RoamingWiFiManager::sortNetworks() {
+    if (scannedNetworkList.empty()) {
+        DBG_PRINTLN_L(3,"sortNetworks: No scanned networks available.");
+        return;
+    }
+    // Desired order:
+    // 1) Detected networks with same SSID as connected (including connected network), sorted by RSSI
+    // 2) Non-detected networks with same SSID as connected (sorted by RSSI)
+    // 3) Other known networks (sorted by RSSI)
+    // 4) Remaining (unknown) networks (sorted by RSSI)
+    // The list is sorted in place on (sortRank, RSSI desc, BSSID), without temporary copies.
+
+    const char* currentSsid = connection.connected ? connection.ssid : "";
+
+    // Refresh group ranks and count adjacent pairs that are out of order.
+    // Zero means the list is already sorted; a few means only some RSSIs or ranks changed.
+    size_t outOfOrder = 0;
+    for (size_t i = 0; i < scannedNetworkList.size(); i++) {
+        ScannedNetwork& net = scannedNetworkList[i];
+        const bool sameSsid = currentSsid[0] != '\0' && strcmp(net.ssid, currentSsid) == 0;
+        if (sameSsid) {
+            net.sortRank = net.detected ? 0 : 1;
+        } else {
+            net.sortRank = net.isKnown() ? 2 : 3;
+        }
+        if (i > 0 && sortsBefore(net, scannedNetworkList[i - 1])) {
+            outOfOrder++;
+        }
+    }
+    if (outOfOrder == 0) {
+        return; // order and index are still valid
+    }
+
+    sortNearlySorted(scannedNetworkList, sortsBefore, outOfOrder, SortInsertionMaxDirty);
+    DBG_PRINTF_L(4,"sortNetworks: %u entries, %u out of order\n", (unsigned)scannedNetworkList.size(), (unsigned)outOfOrder);
+    rebuildNetworkIndex();
+}
+
+bool RoamingWiFiManager::sortsBefore(const ScannedNetwork& a, const ScannedNetwork& b) {
+    if (a.sortRank != b.sortRank) {
+        return a.sortRank < b.sortRank;
+    }
+    const int8_t rssiA = a.smoothedRssi();
+    const int8_t rssiB = b.smoothedRssi();
+    if (rssiA != rssiB) {
+        return rssiA > rssiB;
+    }
+    return a.bssidKey() < b.bssidKey(); // total order, so equal RSSIs don't reshuffle between sorts
+}
+
+
+
+void RoamingWiFiManager::printNetworks() {
+    if (scannedNetworkList.empty()) {
+        DBG_PRINTLN_L(1,"printNetworks: No scanned networks available.");
+        return;
+    }
+
+    DBG_PRINTLN_L(1,"WiFi networks:");
+    for (const auto& net : scannedNetworkList) {
+        DBG_PRINTF_L(1,"SSID: %s, BSSID: %s, RSSI: %d, Channel: %d, %s\n",
+                      net.ssid,
+                      net.bssidStr().c_str(),
+                      net.rssi,
+                      net.channel,
+                      net.encryptionStr());
+    }
+}
+
+// Returns a ScannedNetwork struct if a suitable network is found
+// If no network is found, an empty struct is returned.
+ScannedNetwork RoamingWiFiManager::findBestNetworkVar() {
+    ScannedNetwork bestNetworkVar{};
+
+    // Best scored detected known network, from the per-SSID candidate lists
+    refreshRoamCandidates();
+    const RoamCandidates::Candidate* best = roamCandidates.bestOverall(0); // no radio has key 0
+    if (best != nullptr) {
+        const int pos = findNetworkIndex(best->bssidKey);
+        if (pos >= 0) {
+            bestNetworkVar = scannedNetworkList[(size_t)pos];
+        }
+    }
+    return bestNetworkVar;    
+}
+
+
+void RoamingWiFiManager::connectToStrongestNetwork() {
+    DBG_PRINTLN_L(2,"WiFi: Connecting to strongest known network using cached data...");
 
     ScannedNetwork bestNetworkVar = findBestNetworkVar();
 
@@ -757,21 +1881,17 @@ void RoamingWiFiManager::connectToStrongestNetwork() {
         return;
     }
 
-    const char* bssidStr = bestNetworkVar.bssid.c_str();
     int32_t channel = bestNetworkVar.channel;
+    const char* password = knownNetworks[(size_t)bestNetworkVar.credentialIndex()].password.c_str();
     
-    // Parse BSSID string (format: "XX:XX:XX:XX:XX:XX") into byte array
-    uint8_t bssid[6];
-    if (parseBssid(bssidStr, bssid)) {
+    if (bestNetworkVar.bssidKey() != 0) {
         DBG_PRINTF_L(2,"WiFi: Connecting to %s (RSSI: %d, BSSID: %s, channel: %d)\n", 
-                        bestNetworkVar.ssid.c_str(), bestNetworkVar.rssi, bssidStr, channel);
-        WiFi.begin(bestNetworkVar.ssid, getPasswordOfNetwork(bestNetworkVar.ssid), 
-                    channel, bssid, true);
+                        bestNetworkVar.ssid, bestNetworkVar.rssi, bestNetworkVar.bssidStr().c_str(), channel);
+        WiFi.begin(bestNetworkVar.ssid, password, channel, bestNetworkVar.bssid, true);
     } else {
-        DBG_PRINTF_L(2,"WiFi: Connecting to %s (RSSI: %d) - BSSID parse failed, using channel only\n", 
-                        bestNetworkVar.ssid.c_str(), bestNetworkVar.rssi);
-        WiFi.begin(bestNetworkVar.ssid, getPasswordOfNetwork(bestNetworkVar.ssid), 
-                    channel);
+        DBG_PRINTF_L(2,"WiFi: Connecting to %s (RSSI: %d) - no BSSID, using channel only\n", 
+                        bestNetworkVar.ssid, bestNetworkVar.rssi);
+        WiFi.begin(bestNetworkVar.ssid, password, channel);
     }
     // Wait for connection (with timeout)
     int attempts = 0;
@@ -1003,21 +2123,13 @@ void RoamingWiFiManager::setupScanEndpoints() {
                 return;
             }
 
+            // Set flags instead of queueing here: the scan queue belongs to the loop
             if (rescanOnly && !scannedNetworkList.empty()) {
-                // Only rescan existing networks
-                autoRescanActive = false;
-                const bool started = startAutoRescanNext(false);
-                if (!started) {
-                    request->send(200, "application/json", "{\"message\":\"Scan already in progress or nothing to rescan\"}");
-                } else {
-                    request->send(200, "application/json", "{\"message\":\"Rescan existing networks started\"}");
-                }
+                manualRescanRequested = true;
+                request->send(200, "application/json", "{\"message\":\"Rescan existing networks requested\"}");
             } else {
-                // Full scan across all channels, async.
-                scanPurpose = ScanPurpose::ManualFull;
-                scanNetworksFullAsync();
-                DBG_PRINTLN_L(2,"/wifi/scan: manual full async scan");
-                request->send(200, "application/json", "{\"message\":\"Full async scan started\"}");
+                manualFullScanRequested = true;
+                request->send(200, "application/json", "{\"message\":\"Full async scan requested\"}");
             }
             delete st;
             request->_tempObject = nullptr;
@@ -1129,6 +2241,65 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         bool rescanTestChannels = doc["rescanTestChannels"] | autoRescanTestChannels;
         bool rescanSkipNotDetected = doc["rescanSkipNotDetected"] | autoRescanSkipNotDetected;
         float rescanWaitIntervalSec = doc["rescanWaitIntervalSec"] | autoRescanWaitIntervalSec;
+        bool rescanGroupRadios = doc["rescanGroupRadios"] | autoRescanGroupRadios;
+        bool rescanByChannel = doc["rescanByChannel"] | autoRescanByChannel;
+        bool rescanPriority = doc["rescanPriority"] | autoRescanPriority;
+        float exploreRate = doc["testChannelExploreRate"] | testChannelExploreRate;
+        float airPercent = doc["airtimeBudgetPercent"] | airtimeBudgetPercent;
+        uint32_t airWindowMs = doc["airtimeWindowMs"] | airtimeWindowMs;
+        float rescanMinIntervalSec = doc["rescanMinIntervalSec"] | autoRescanMinIntervalSec;
+        float rescanMaxIntervalSec = doc["rescanMaxIntervalSec"] | autoRescanMaxIntervalSec;
+        const char* connectedModeName = doc["connectedFullScanMode"] | toString(fullScanConnectedMode);
+        uint32_t homeDwellMs = doc["fullScanHomeDwellMs"] | fullScanHomeDwellMs;
+        uint32_t chunkChannels = doc["fullScanChunkChannels"] | fullScanChunkChannels;
+        bool progressive = doc["fullScanProgressive"] | fullScanProgressive;
+        bool rssiEvents = doc["rssiEventScanning"] | rssiEventScanning;
+        int32_t rescanDbm = doc["rssiRescanThresholdDbm"] | rssiRescanThresholdDbm;
+        int32_t fullDbm = doc["rssiFullScanThresholdDbm"] | rssiFullScanThresholdDbm;
+        uint32_t hysteresisDb = doc["rssiHysteresisDb"] | rssiHysteresisDb;
+        float edgeIntervalSec = doc["rssiEdgeFullIntervalSec"] | rssiEdgeFullIntervalSec;
+        uint32_t connRssiMs = doc["connectedRssiSampleMs"] | connectedRssiSampleMs;
+        bool directed = doc["directedScans"] | directedScans;
+        bool harvest = doc["beaconHarvest"] | beaconHarvest;
+        bool directedFilter = doc["directedScanFilter"] | directedScanFilter;
+        uint32_t directedDwellMs = doc["directedScanDwellMs"] | directedScanDwellMs;
+        if (!(directedDwellMs >= 10 && directedDwellMs <= 200)) {
+            sendJsonError(request, 400, "directedScanDwellMs out of range (10..200)");
+            return;
+        }
+        if (!(connRssiMs == 0 || (connRssiMs >= 50 && connRssiMs <= 10000))) {
+            sendJsonError(request, 400, "connectedRssiSampleMs out of range (0 or 50..10000)");
+            return;
+        }
+        if (!(rescanDbm >= -100 && rescanDbm <= -30)) {
+            sendJsonError(request, 400, "rssiRescanThresholdDbm out of range (-100..-30)");
+            return;
+        }
+        if (!(fullDbm >= -100 && fullDbm < rescanDbm)) {
+            sendJsonError(request, 400, "rssiFullScanThresholdDbm out of range (-100..rssiRescanThresholdDbm-1)");
+            return;
+        }
+        if (hysteresisDb > 20) {
+            sendJsonError(request, 400, "rssiHysteresisDb out of range (0..20)");
+            return;
+        }
+        if (!(edgeIntervalSec >= 1.0f && edgeIntervalSec <= 3600.0f)) {
+            sendJsonError(request, 400, "rssiEdgeFullIntervalSec out of range (1..3600)");
+            return;
+        }
+        FullScanMode connectedMode;
+        if (!parseFullScanMode(connectedModeName, connectedMode)) {
+            sendJsonError(request, 400, "connectedFullScanMode must be burst, homeDwell or chunked");
+            return;
+        }
+        if (!(homeDwellMs >= 30 && homeDwellMs <= 1000)) {
+            sendJsonError(request, 400, "fullScanHomeDwellMs out of range (30..1000)");
+            return;
+        }
+        if (!(chunkChannels >= 1 && chunkChannels <= 28)) {
+            sendJsonError(request, 400, "fullScanChunkChannels out of range (1..28)");
+            return;
+        }
         if (!(rescanIntervalSec >= 0.1f && rescanIntervalSec <= 3600.0f)) {
             sendJsonError(request, 400, "rescanIntervalSec out of range (0.1..3600)");
             return;
@@ -1137,6 +2308,26 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
             sendJsonError(request, 400, "rescanWaitIntervalSec out of range (0.0..10.0)");
             return;
         }
+        if (!(exploreRate >= 0.0f && exploreRate <= 1.0f)) {
+            sendJsonError(request, 400, "testChannelExploreRate out of range (0.0..1.0)");
+            return;
+        }
+        if (!(airPercent >= 1.0f && airPercent <= 100.0f)) {
+            sendJsonError(request, 400, "airtimeBudgetPercent out of range (1..100)");
+            return;
+        }
+        if (!(airWindowMs >= 100 && airWindowMs <= 10000)) {
+            sendJsonError(request, 400, "airtimeWindowMs out of range (100..10000)");
+            return;
+        }
+        if (!(rescanMinIntervalSec >= 0.1f && rescanMinIntervalSec <= 3600.0f)) {
+            sendJsonError(request, 400, "rescanMinIntervalSec out of range (0.1..3600)");
+            return;
+        }
+        if (!(rescanMaxIntervalSec >= rescanMinIntervalSec && rescanMaxIntervalSec <= 3600.0f)) {
+            sendJsonError(request, 400, "rescanMaxIntervalSec out of range (rescanMinIntervalSec..3600)");
+            return;
+        }
 
         DBG_PRINTF_L(2,
             "WiFi: Auto full-scan %s (%.1f sec), auto rescan %s (%.1f sec), known-only=%s, test-channels=%s, skip-not-detected=%s, wait-interval=%.2f sec\n",
@@ -1159,6 +2350,31 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         autoRescanTestChannels = rescanTestChannels;
         autoRescanSkipNotDetected = rescanSkipNotDetected;
         autoRescanWaitIntervalSec = rescanWaitIntervalSec;
+        autoRescanGroupRadios = rescanGroupRadios;
+        autoRescanByChannel = rescanByChannel;
+        autoRescanPriority = rescanPriority;
+        testChannelExploreRate = exploreRate;
+        airtimeBudgetPercent = airPercent;
+        airtimeWindowMs = airWindowMs;
+        airtimeConfigPending = true;
+        autoRescanMinIntervalSec = rescanMinIntervalSec;
+        autoRescanMaxIntervalSec = rescanMaxIntervalSec;
+        fullScanConnectedMode = connectedMode;
+        fullScanHomeDwellMs = homeDwellMs;
+        fullScanChunkChannels = chunkChannels;
+        fullScanProgressive = progressive;
+        rssiEventScanning = rssiEvents;
+        rssiRescanThresholdDbm = rescanDbm;
+        rssiFullScanThresholdDbm = fullDbm;
+        rssiHysteresisDb = hysteresisDb;
+        rssiEdgeFullIntervalSec = edgeIntervalSec;
+        rssiArmedBssid = 0; // evaluate and arm again
+        connectedRssiSampleMs = connRssiMs;
+        directedScans = directed;
+        directedScanFilter = directedFilter;
+        directedScanDwellMs = directedDwellMs;
+        beaconHarvest = harvest;
+        applyBeaconHarvest();
 
         wifiPrefs.putBool("autoFullEn", autoFullScanEnabled);
         wifiPrefs.putFloat("autoFullIntSecF", autoFullScanIntervalSec);
@@ -1168,16 +2384,31 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         wifiPrefs.putBool("autoRescTestCh", autoRescanTestChannels);
         wifiPrefs.putBool("autoRescSkipNd", autoRescanSkipNotDetected);
         wifiPrefs.putFloat("autoRescWaSecF", autoRescanWaitIntervalSec);
+        wifiPrefs.putBool("autoRescGrpRad", autoRescanGroupRadios);
+        wifiPrefs.putBool("autoRescByCh", autoRescanByChannel);
+        wifiPrefs.putBool("autoRescPrio", autoRescanPriority);
+        wifiPrefs.putFloat("autoRescMinSecF", autoRescanMinIntervalSec);
+        wifiPrefs.putFloat("autoRescMaxSecF", autoRescanMaxIntervalSec);
+        wifiPrefs.putFloat("testChExplF", testChannelExploreRate);
+        wifiPrefs.putFloat("airtimePctF", airtimeBudgetPercent);
+        wifiPrefs.putUInt("airtimeWinMs", airtimeWindowMs);
+        wifiPrefs.putUChar("fullScanMode", (uint8_t)fullScanConnectedMode);
+        wifiPrefs.putUInt("fullScanHomeMs", fullScanHomeDwellMs);
+        wifiPrefs.putUInt("fullScanChunk", fullScanChunkChannels);
+        wifiPrefs.putBool("fullScanProgr", fullScanProgressive);
+        wifiPrefs.putBool("rssiEvtEn", rssiEventScanning);
+        wifiPrefs.putInt("rssiRescDbm", rssiRescanThresholdDbm);
+        wifiPrefs.putInt("rssiFullDbm", rssiFullScanThresholdDbm);
+        wifiPrefs.putUInt("rssiHystDb", rssiHysteresisDb);
+        wifiPrefs.putFloat("rssiEdgeSecF", rssiEdgeFullIntervalSec);
+        wifiPrefs.putUInt("connRssiMs", connectedRssiSampleMs);
+        wifiPrefs.putBool("dirScanEn", directedScans);
+        wifiPrefs.putBool("dirScanFilt", directedScanFilter);
+        wifiPrefs.putUInt("dirScanDwMs", directedScanDwellMs);
+        wifiPrefs.putBool("harvestEn", beaconHarvest);
 
         // Reset any in-progress rescan sequence when settings change.
-        autoRescanActive = false;
-        autoRescanIndex = 0;
-        autoRescanTargetBssid = "";
-        autoRescanTargetChannel = 0;
-        autoRescanKnownOnly = false;
-        if (scanPurpose == ScanPurpose::AutoRescanSingle) {
-            scanPurpose = ScanPurpose::None;
-        }
+        sweepResetRequested = true;
 
 
         JsonDocument resp;
@@ -1190,6 +2421,28 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         resp["rescanTestChannels"] = autoRescanTestChannels;
         resp["rescanSkipNotDetected"] = autoRescanSkipNotDetected;
         resp["rescanWaitIntervalSec"] = autoRescanWaitIntervalSec;
+        resp["rescanGroupRadios"] = autoRescanGroupRadios;
+        resp["rescanByChannel"] = autoRescanByChannel;
+        resp["rescanPriority"] = autoRescanPriority;
+        resp["testChannelExploreRate"] = testChannelExploreRate;
+        resp["airtimeBudgetPercent"] = airtimeBudgetPercent;
+        resp["airtimeWindowMs"] = airtimeWindowMs;
+        resp["rescanMinIntervalSec"] = autoRescanMinIntervalSec;
+        resp["rescanMaxIntervalSec"] = autoRescanMaxIntervalSec;
+        resp["connectedFullScanMode"] = toString(fullScanConnectedMode);
+        resp["fullScanHomeDwellMs"] = fullScanHomeDwellMs;
+        resp["fullScanChunkChannels"] = fullScanChunkChannels;
+        resp["fullScanProgressive"] = fullScanProgressive;
+        resp["rssiEventScanning"] = rssiEventScanning;
+        resp["rssiRescanThresholdDbm"] = rssiRescanThresholdDbm;
+        resp["rssiFullScanThresholdDbm"] = rssiFullScanThresholdDbm;
+        resp["rssiHysteresisDb"] = rssiHysteresisDb;
+        resp["rssiEdgeFullIntervalSec"] = rssiEdgeFullIntervalSec;
+        resp["connectedRssiSampleMs"] = connectedRssiSampleMs;
+        resp["directedScans"] = directedScans;
+        resp["directedScanFilter"] = directedScanFilter;
+        resp["directedScanDwellMs"] = directedScanDwellMs;
+        resp["beaconHarvest"] = beaconHarvest;
         String result;
         serializeJson(resp, result);
         request->send(200, "application/json", result);
@@ -1211,6 +2464,9 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
 
         uint32_t nonDfsMs = doc["scanTimeNonDfsMs"] | scanTimeNonDfsMs;
         uint32_t dfsMs = doc["scanTimeDfsMs"] | scanTimeDfsMs;
+        bool adaptive = doc["adaptiveDwell"] | adaptiveDwell;
+        uint32_t minMs = doc["dwellMinMs"] | dwellMinMs;
+        uint32_t maxMs = doc["dwellMaxMs"] | dwellMaxMs;
         
         if (!(nonDfsMs >= 10 && nonDfsMs <= 1000)) {
             sendJsonError(request, 400, "scanTimeNonDfsMs out of range (10..1000)");
@@ -1220,18 +2476,95 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
             sendJsonError(request, 400, "scanTimeDfsMs out of range (10..1000)");
             return;
         }
+        if (!(minMs >= 10 && minMs <= 1000)) {
+            sendJsonError(request, 400, "dwellMinMs out of range (10..1000)");
+            return;
+        }
+        if (!(maxMs >= minMs && maxMs <= 1000)) {
+            sendJsonError(request, 400, "dwellMaxMs out of range (dwellMinMs..1000)");
+            return;
+        }
 
+        if (nonDfsMs != scanTimeNonDfsMs || dfsMs != scanTimeDfsMs) {
+            channelDwell.reset(); // learn again from the new starting points
+        }
         scanTimeNonDfsMs = nonDfsMs;
         scanTimeDfsMs = dfsMs;
+        adaptiveDwell = adaptive;
+        dwellMinMs = minMs;
+        dwellMaxMs = maxMs;
+        channelDwell.setBounds((uint16_t)dwellMinMs, (uint16_t)dwellMaxMs);
         wifiPrefs.putUInt("scanTimeNonDfs", scanTimeNonDfsMs);
         wifiPrefs.putUInt("scanTimeDfs", scanTimeDfsMs);
+        wifiPrefs.putBool("dwellAdaptive", adaptiveDwell);
+        wifiPrefs.putUInt("dwellMinMs", dwellMinMs);
+        wifiPrefs.putUInt("dwellMaxMs", dwellMaxMs);
 
-        DBG_PRINTF_L(2,"WiFi: Scan times updated - Non-DFS: %u ms, DFS: %u ms\n", scanTimeNonDfsMs, scanTimeDfsMs);
+        DBG_PRINTF_L(2,"WiFi: Scan times updated - Non-DFS: %u ms, DFS: %u ms, adaptive: %d (%u..%u ms)\n",
+            scanTimeNonDfsMs, scanTimeDfsMs, (int)adaptiveDwell, dwellMinMs, dwellMaxMs);
 
         JsonDocument resp;
         resp["message"] = "Scan times updated";
         resp["scanTimeNonDfsMs"] = scanTimeNonDfsMs;
         resp["scanTimeDfsMs"] = scanTimeDfsMs;
+        resp["adaptiveDwell"] = adaptiveDwell;
+        resp["dwellMinMs"] = dwellMinMs;
+        resp["dwellMaxMs"] = dwellMaxMs;
+        String result;
+        serializeJson(resp, result);
+        request->send(200, "application/json", result);
+    });
+
+    server.on("/wifi/apTable", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        if (!checkHttpAuth(request)) return;
+        request->send(200, "application/json", "{\"message\":\"AP table settings updated\"}");
+    }, nullptr, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (!checkHttpAuth(request)) return;
+        String body = "";
+        for (size_t i = 0; i < len; i++) {
+            body += (char)data[i];
+        }
+        JsonDocument doc;
+        if (!tryParseJson(body, doc, request)) {
+            return;
+        }
+
+        uint32_t capacity = doc["capacity"] | apTableCapacity;
+        float maxAgeSec = doc["maxAgeSec"] | apTableMaxAgeSec;
+        uint32_t unknownTopK = doc["unknownTopK"] | apUnknownTopK;
+        bool dropUnknown = doc["dropUnknown"] | apDropUnknown;
+        if (!(capacity >= 8 && capacity <= 1024)) {
+            sendJsonError(request, 400, "capacity out of range (8..1024)");
+            return;
+        }
+        if (!(maxAgeSec >= 0.0f && maxAgeSec <= 86400.0f)) {
+            sendJsonError(request, 400, "maxAgeSec out of range (0..86400)");
+            return;
+        }
+        if (unknownTopK > 1024) {
+            sendJsonError(request, 400, "unknownTopK out of range (0..1024)");
+            return;
+        }
+
+        apTableCapacity = capacity;
+        apTableMaxAgeSec = maxAgeSec;
+        wifiPrefs.putUInt("apTableCap", apTableCapacity);
+        wifiPrefs.putFloat("apMaxAgeSecF", apTableMaxAgeSec);
+        apUnknownTopK = unknownTopK;
+        apDropUnknown = dropUnknown;
+        wifiPrefs.putUInt("apUnkTopK", apUnknownTopK);
+        wifiPrefs.putBool("apDropUnk", apDropUnknown);
+        // Applied at the next scan completion, so an ongoing rescan sweep is not disturbed.
+
+        DBG_PRINTF_L(2,"WiFi: AP table capacity %u, max age %.0f sec, unknown top-K %u%s\n", apTableCapacity, (double)apTableMaxAgeSec,
+            apUnknownTopK, apDropUnknown ? " (unknown SSIDs dropped)" : "");
+
+        JsonDocument resp;
+        resp["message"] = "AP table settings updated";
+        resp["capacity"] = apTableCapacity;
+        resp["maxAgeSec"] = apTableMaxAgeSec;
+        resp["unknownTopK"] = apUnknownTopK;
+        resp["dropUnknown"] = apDropUnknown;
         String result;
         serializeJson(resp, result);
         request->send(200, "application/json", result);
@@ -1311,6 +2644,31 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         autoRescanTestChannels = true;
         autoRescanSkipNotDetected = true;
         autoRescanWaitIntervalSec = 10.0f;
+        autoRescanGroupRadios = true;
+        autoRescanByChannel = false;
+        autoRescanPriority = true;
+        testChannelExploreRate = 0.2f;
+        airtimeBudgetPercent = 10.0f;
+        airtimeWindowMs = 1000;
+        airtimeConfigPending = true;
+        autoRescanMinIntervalSec = 2.0f;
+        autoRescanMaxIntervalSec = 30.0f;
+        fullScanConnectedMode = FullScanMode::Chunked;
+        fullScanHomeDwellMs = 100;
+        fullScanChunkChannels = 2;
+        fullScanProgressive = true;
+        rssiEventScanning = false;
+        rssiRescanThresholdDbm = -70;
+        rssiFullScanThresholdDbm = -80;
+        rssiHysteresisDb = 5;
+        rssiEdgeFullIntervalSec = 10.0f;
+        rssiArmedBssid = 0;
+        connectedRssiSampleMs = 500;
+        directedScans = false;
+        directedScanFilter = true;
+        directedScanDwellMs = 30;
+        beaconHarvest = false;
+        applyBeaconHarvest();
         statusRefreshIntervalSec = 0.5f;
         statusAutoRefreshEnabled = true;
         autoReconnectEnabled = true;
@@ -1318,9 +2676,22 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         autoRoamEnabled = true;
         autoRoamDeltaRssiDbm = 10.0f;
         autoRoamSameSsidOnly = true;
+        autoRoamScoring = true;
+        scoreDfsPenaltyDb = 3;
+        scoreFailPenaltyDb = 8;
+        roamScoringChanged = true;
         bssidAliasesUrl = "";
         scanTimeNonDfsMs = 50;
         scanTimeDfsMs = 200;
+        adaptiveDwell = true;
+        dwellMinMs = 20;
+        dwellMaxMs = 400;
+        channelDwell.reset();
+        channelDwell.setBounds((uint16_t)dwellMinMs, (uint16_t)dwellMaxMs);
+        apTableCapacity = 128;
+        apTableMaxAgeSec = 600.0f;
+        apUnknownTopK = 32;
+        apDropUnknown = false;
 
         // Persist defaults to NVS
         wifiPrefs.putBool("autoFullEn", autoFullScanEnabled);
@@ -1331,6 +2702,28 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         wifiPrefs.putBool("autoRescTestCh", autoRescanTestChannels);
         wifiPrefs.putBool("autoRescSkipNd", autoRescanSkipNotDetected);
         wifiPrefs.putFloat("autoRescWaSecF", autoRescanWaitIntervalSec);
+        wifiPrefs.putBool("autoRescGrpRad", autoRescanGroupRadios);
+        wifiPrefs.putBool("autoRescByCh", autoRescanByChannel);
+        wifiPrefs.putBool("autoRescPrio", autoRescanPriority);
+        wifiPrefs.putFloat("autoRescMinSecF", autoRescanMinIntervalSec);
+        wifiPrefs.putFloat("autoRescMaxSecF", autoRescanMaxIntervalSec);
+        wifiPrefs.putFloat("testChExplF", testChannelExploreRate);
+        wifiPrefs.putFloat("airtimePctF", airtimeBudgetPercent);
+        wifiPrefs.putUInt("airtimeWinMs", airtimeWindowMs);
+        wifiPrefs.putUChar("fullScanMode", (uint8_t)fullScanConnectedMode);
+        wifiPrefs.putUInt("fullScanHomeMs", fullScanHomeDwellMs);
+        wifiPrefs.putUInt("fullScanChunk", fullScanChunkChannels);
+        wifiPrefs.putBool("fullScanProgr", fullScanProgressive);
+        wifiPrefs.putBool("rssiEvtEn", rssiEventScanning);
+        wifiPrefs.putInt("rssiRescDbm", rssiRescanThresholdDbm);
+        wifiPrefs.putInt("rssiFullDbm", rssiFullScanThresholdDbm);
+        wifiPrefs.putUInt("rssiHystDb", rssiHysteresisDb);
+        wifiPrefs.putFloat("rssiEdgeSecF", rssiEdgeFullIntervalSec);
+        wifiPrefs.putUInt("connRssiMs", connectedRssiSampleMs);
+        wifiPrefs.putBool("dirScanEn", directedScans);
+        wifiPrefs.putBool("dirScanFilt", directedScanFilter);
+        wifiPrefs.putUInt("dirScanDwMs", directedScanDwellMs);
+        wifiPrefs.putBool("harvestEn", beaconHarvest);
         wifiPrefs.putFloat("statusIntSecF", statusRefreshIntervalSec);
         wifiPrefs.putBool("statusAutoEn", statusAutoRefreshEnabled);
         wifiPrefs.putUInt("reconEn", autoReconnectEnabled ? 1 : 0);
@@ -1339,19 +2732,22 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         wifiPrefs.putBool("roamAutoEn", autoRoamEnabled);
         wifiPrefs.putFloat("roamDeltaDbmF", autoRoamDeltaRssiDbm);
         wifiPrefs.putBool("roamSameSsid", autoRoamSameSsidOnly);
+        wifiPrefs.putBool("roamScoreEn", autoRoamScoring);
+        wifiPrefs.putUInt("roamDfsPenDb", scoreDfsPenaltyDb);
+        wifiPrefs.putUInt("roamFailPenDb", scoreFailPenaltyDb);
         wifiPrefs.putInt("debugLevel", debugLevel);
         wifiPrefs.putUInt("scanTimeNonDfs", scanTimeNonDfsMs);
         wifiPrefs.putUInt("scanTimeDfs", scanTimeDfsMs);
+        wifiPrefs.putBool("dwellAdaptive", adaptiveDwell);
+        wifiPrefs.putUInt("dwellMinMs", dwellMinMs);
+        wifiPrefs.putUInt("dwellMaxMs", dwellMaxMs);
+        wifiPrefs.putUInt("apTableCap", apTableCapacity);
+        wifiPrefs.putFloat("apMaxAgeSecF", apTableMaxAgeSec);
+        wifiPrefs.putUInt("apUnkTopK", apUnknownTopK);
+        wifiPrefs.putBool("apDropUnk", apDropUnknown);
 
         // Reset any in-progress scan/rescan sequences
-        autoRescanActive = false;
-        autoRescanIndex = 0;
-        autoRescanTargetBssid = "";
-        autoRescanTargetChannel = 0;
-        autoRescanKnownOnly = false;
-        if (scanPurpose == ScanPurpose::AutoRescanSingle || scanPurpose == ScanPurpose::AutoRescanTestChannel) {
-            scanPurpose = ScanPurpose::None;
-        }
+        sweepResetRequested = true;
 
         JsonDocument resp;
         resp["message"] = "Defaults restored";
@@ -1364,6 +2760,28 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         resp["autoRescanTestChannels"] = autoRescanTestChannels;
         resp["autoRescanSkipNotDetected"] = autoRescanSkipNotDetected;
         resp["autoRescanWaitIntervalSec"] = autoRescanWaitIntervalSec;
+        resp["autoRescanGroupRadios"] = autoRescanGroupRadios;
+        resp["autoRescanByChannel"] = autoRescanByChannel;
+        resp["autoRescanPriority"] = autoRescanPriority;
+        resp["testChannelExploreRate"] = testChannelExploreRate;
+        resp["airtimeBudgetPercent"] = airtimeBudgetPercent;
+        resp["airtimeWindowMs"] = airtimeWindowMs;
+        resp["autoRescanMinIntervalSec"] = autoRescanMinIntervalSec;
+        resp["autoRescanMaxIntervalSec"] = autoRescanMaxIntervalSec;
+        resp["connectedFullScanMode"] = toString(fullScanConnectedMode);
+        resp["fullScanHomeDwellMs"] = fullScanHomeDwellMs;
+        resp["fullScanChunkChannels"] = fullScanChunkChannels;
+        resp["fullScanProgressive"] = fullScanProgressive;
+        resp["rssiEventScanning"] = rssiEventScanning;
+        resp["rssiRescanThresholdDbm"] = rssiRescanThresholdDbm;
+        resp["rssiFullScanThresholdDbm"] = rssiFullScanThresholdDbm;
+        resp["rssiHysteresisDb"] = rssiHysteresisDb;
+        resp["rssiEdgeFullIntervalSec"] = rssiEdgeFullIntervalSec;
+        resp["connectedRssiSampleMs"] = connectedRssiSampleMs;
+        resp["directedScans"] = directedScans;
+        resp["directedScanFilter"] = directedScanFilter;
+        resp["directedScanDwellMs"] = directedScanDwellMs;
+        resp["beaconHarvest"] = beaconHarvest;
         resp["statusRefreshIntervalSec"] = statusRefreshIntervalSec;
         resp["statusAutoRefreshEnabled"] = statusAutoRefreshEnabled;
         resp["autoReconnectEnabled"] = autoReconnectEnabled;
@@ -1371,8 +2789,15 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         resp["autoRoamEnabled"] = autoRoamEnabled;
         resp["autoRoamDeltaRssiDbm"] = autoRoamDeltaRssiDbm;
         resp["autoRoamSameSsidOnly"] = autoRoamSameSsidOnly;
+        resp["autoRoamScoring"] = autoRoamScoring;
+        resp["autoRoamDfsPenaltyDb"] = scoreDfsPenaltyDb;
+        resp["autoRoamFailPenaltyDb"] = scoreFailPenaltyDb;
         resp["debugLevel"] = debugLevel;
         resp["bssidAliasesUrl"] = bssidAliasesUrl;
+        resp["apTableCapacity"] = apTableCapacity;
+        resp["apTableMaxAgeSec"] = apTableMaxAgeSec;
+        resp["apUnknownTopK"] = apUnknownTopK;
+        resp["apDropUnknown"] = apDropUnknown;
         String result;
         serializeJson(resp, result);
         request->send(200, "application/json", result);
@@ -1396,24 +2821,45 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         bool enabled = doc["enabled"] | autoRoamEnabled;
         float deltaDbm = doc["deltaDbm"] | autoRoamDeltaRssiDbm;
         bool sameSsidOnly = doc["sameSsidOnly"] | autoRoamSameSsidOnly;
+        bool scoring = doc["scoring"] | autoRoamScoring;
+        int dfsPenaltyDb = doc["dfsPenaltyDb"] | (int)scoreDfsPenaltyDb;
+        int failPenaltyDb = doc["failPenaltyDb"] | (int)scoreFailPenaltyDb;
         // Validate bounds
         if (!(deltaDbm >= 1.0f && deltaDbm <= 50.0f)) {
             sendJsonError(request, 400, "deltaDbm out of range (1..50)");
             return;
         }
+        if (dfsPenaltyDb < 0 || dfsPenaltyDb > 30) {
+            sendJsonError(request, 400, "dfsPenaltyDb out of range (0..30)");
+            return;
+        }
+        if (failPenaltyDb < 0 || failPenaltyDb > 30) {
+            sendJsonError(request, 400, "failPenaltyDb out of range (0..30)");
+            return;
+        }
 
         autoRoamEnabled = enabled;
         autoRoamDeltaRssiDbm = deltaDbm;
         autoRoamSameSsidOnly = sameSsidOnly;
+        autoRoamScoring = scoring;
+        scoreDfsPenaltyDb = (uint32_t)dfsPenaltyDb;
+        scoreFailPenaltyDb = (uint32_t)failPenaltyDb;
+        roamScoringChanged = true; // the loop ranks the candidates again with the new scoring
         wifiPrefs.putBool("roamAutoEn", autoRoamEnabled);
         wifiPrefs.putFloat("roamDeltaDbmF", autoRoamDeltaRssiDbm);
         wifiPrefs.putBool("roamSameSsid", autoRoamSameSsidOnly);
+        wifiPrefs.putBool("roamScoreEn", autoRoamScoring);
+        wifiPrefs.putUInt("roamDfsPenDb", scoreDfsPenaltyDb);
+        wifiPrefs.putUInt("roamFailPenDb", scoreFailPenaltyDb);
 
         JsonDocument resp;
         resp["message"] = "Auto-roam setting updated";
         resp["enabled"] = autoRoamEnabled;
         resp["deltaDbm"] = autoRoamDeltaRssiDbm;
         resp["sameSsidOnly"] = autoRoamSameSsidOnly;
+        resp["scoring"] = autoRoamScoring;
+        resp["dfsPenaltyDb"] = scoreDfsPenaltyDb;
+        resp["failPenaltyDb"] = scoreFailPenaltyDb;
         String result;
         serializeJson(resp, result);
         request->send(200, "application/json", result);
@@ -1508,10 +2954,36 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         doc["autoRescanTestChannels"] = autoRescanTestChannels;
         doc["autoRescanSkipNotDetected"] = autoRescanSkipNotDetected;
         doc["autoRescanWaitIntervalSec"] = autoRescanWaitIntervalSec;
+        doc["autoRescanGroupRadios"] = autoRescanGroupRadios;
+        doc["autoRescanByChannel"] = autoRescanByChannel;
+        doc["autoRescanPriority"] = autoRescanPriority;
+        doc["testChannelExploreRate"] = testChannelExploreRate;
+        doc["airtimeBudgetPercent"] = airtimeBudgetPercent;
+        doc["airtimeWindowMs"] = airtimeWindowMs;
+        doc["autoRescanMinIntervalSec"] = autoRescanMinIntervalSec;
+        doc["autoRescanMaxIntervalSec"] = autoRescanMaxIntervalSec;
+        doc["connectedFullScanMode"] = toString(fullScanConnectedMode);
+        doc["fullScanHomeDwellMs"] = fullScanHomeDwellMs;
+        doc["fullScanChunkChannels"] = fullScanChunkChannels;
+        doc["fullScanProgressive"] = fullScanProgressive;
+        doc["rssiEventScanning"] = rssiEventScanning;
+        doc["rssiRescanThresholdDbm"] = rssiRescanThresholdDbm;
+        doc["rssiFullScanThresholdDbm"] = rssiFullScanThresholdDbm;
+        doc["rssiHysteresisDb"] = rssiHysteresisDb;
+        doc["rssiEdgeFullIntervalSec"] = rssiEdgeFullIntervalSec;
+        doc["connectedRssiSampleMs"] = connectedRssiSampleMs;
+        doc["directedScans"] = directedScans;
+        doc["directedScanFilter"] = directedScanFilter;
+        doc["directedScanDwellMs"] = directedScanDwellMs;
+        doc["beaconHarvest"] = beaconHarvest;
+        doc["autoRescanSharedRadioSkips"] = autoRescanSharedRadioSkipCount;
         // Auto-roam fields
         doc["autoRoamEnabled"] = autoRoamEnabled;
         doc["autoRoamDeltaRssiDbm"] = autoRoamDeltaRssiDbm;
         doc["autoRoamSameSsidOnly"] = autoRoamSameSsidOnly;
+        doc["autoRoamScoring"] = autoRoamScoring;
+        doc["autoRoamDfsPenaltyDb"] = scoreDfsPenaltyDb;
+        doc["autoRoamFailPenaltyDb"] = scoreFailPenaltyDb;
 
         doc["statusRefreshIntervalSec"] = statusRefreshIntervalSec;
         doc["statusAutoRefreshEnabled"] = statusAutoRefreshEnabled;
@@ -1523,6 +2995,20 @@ void RoamingWiFiManager::setupSettingsEndpoints() {
         // Scan time settings
         doc["scanTimeNonDfsMs"] = scanTimeNonDfsMs;
         doc["scanTimeDfsMs"] = scanTimeDfsMs;
+        doc["adaptiveDwell"] = adaptiveDwell;
+        doc["dwellMinMs"] = dwellMinMs;
+        doc["dwellMaxMs"] = dwellMaxMs;
+
+        // AP table limits and eviction counters
+        doc["apTableCapacity"] = apTableCapacity;
+        doc["apTableMaxAgeSec"] = apTableMaxAgeSec;
+        doc["apTableSize"] = (uint32_t)scannedNetworkList.size();
+        doc["apTableEvictedCapacity"] = apTableEvictedCapacityCount;
+        doc["apTableEvictedAge"] = apTableEvictedAgeCount;
+        doc["apUnknownTopK"] = apUnknownTopK;
+        doc["apDropUnknown"] = apDropUnknown;
+        doc["apTableEvictedPolicy"] = apTableEvictedPolicyCount;
+        doc["apIngestSkipped"] = apIngestSkippedCount;
         
         String result;
         serializeJson(doc, result);
@@ -1613,7 +3099,67 @@ String RoamingWiFiManager::getWiFiStatus() {
     doc["saved_bssid"] = savedBSSID; // expose persisted BSSID
     doc["saved_ssid"] = savedSSID;
     doc["saved_channel"] = savedChannel;
-    doc["autoRescanTargetChannel"] = autoRescanTestChannelList[autoRescanTestChannelIndex];
+    doc["autoRescanTargetChannel"] = (autoRescanTestChannelIndex >= 0) ? autoRescanTestChannelList[(size_t)autoRescanTestChannelIndex] : 0;
+
+    // RSSI-event driven scanning
+    JsonObject link = doc["linkLevel"].to<JsonObject>();
+    link["eventScanning"] = rssiEventScanning;
+    link["level"] = (rssiEventScanning && connection.connected) ? toString(linkLevel) : "n/a";
+    link["rssiLowEvents"] = rssiLowEventCount;
+    link["lastEventRssi"] = (int)rssiLowLastRssi;
+    link["levelChanges"] = linkLevelChangeCount;
+
+    // Passive beacon harvesting
+    JsonObject harvest = doc["beaconHarvest"].to<JsonObject>();
+    harvest["enabled"] = beaconHarvest;
+    harvest["active"] = promiscuousActive;
+    harvest["frames"] = harvester.frames();
+    harvest["beacons"] = harvester.beacons();
+    harvest["dropped"] = harvester.dropped();
+    harvest["tableUpdates"] = harvestUpdateCount;
+    harvest["channelUtilisationPercent"] = channelUtilisationPercent;
+    harvest["avgChannelUtilisationPercent"] = channelUtilisationAvgPercent;
+
+    // Connected-AP RSSI trace, oldest sample first
+    JsonObject connRssi = doc["connectedRssi"].to<JsonObject>();
+    connRssi["sampleMs"] = connectedRssiSampleMs;
+    connRssi["samples"] = (uint32_t)connectedRssiTraceCount;
+    JsonArray traceAge = connRssi["traceAgeMs"].to<JsonArray>();
+    JsonArray traceRssi = connRssi["traceRssi"].to<JsonArray>();
+    const size_t traceLen = std::min(connectedRssiTraceCount, ConnectedRssiTraceSize);
+    const uint32_t traceNow = millis();
+    for (size_t i = connectedRssiTraceCount - traceLen; i < connectedRssiTraceCount; i++) {
+        const RssiSample& sample = connectedRssiTrace[i % ConnectedRssiTraceSize];
+        traceAge.add(traceNow - sample.timeMs);
+        traceRssi.add(sample.rssi);
+    }
+
+    // Scan job queue
+    JsonObject queue = doc["scanQueue"].to<JsonObject>();
+    queue["depth"] = (uint32_t)scanJobs.size();
+    queue["maxDepth"] = (uint32_t)scanJobs.maxDepth();
+    queue["running"] = scanInProgress ? ::toString(runningScanJob.priority) : "none";
+    queue["started"] = scanJobs.started();
+    queue["preempted"] = scanPreemptedCount;
+    queue["dropped"] = scanJobs.dropped();
+    queue["lastWaitMs"] = scanJobs.lastWaitMs();
+    queue["avgWaitMs"] = scanJobs.avgWaitMs();
+    queue["maxWaitMs"] = scanJobs.maxWaitMs();
+    const ScanJob* next = scanJobs.peek();
+    queue["nextWaitMs"] = (next != nullptr) ? (uint32_t)(millis() - next->enqueuedMs) : 0; // how long the most urgent job has waited so far
+
+    // Off-channel airtime of scans while connected
+    JsonObject air = doc["airtime"].to<JsonObject>();
+    air["budgetPercent"] = airtimeBudgetPercent;
+    air["windowMs"] = airtimeWindowMs;
+    portENTER_CRITICAL(&airtimeStatsMux);
+    const AirtimeBudget::Stats airStats = airtimeStats;
+    portEXIT_CRITICAL(&airtimeStatsMux);
+    air["lastWindowPercent"] = airStats.lastWindowPercent;
+    air["maxWindowPercent"] = airStats.maxWindowPercent;
+    air["offChannelTotalSec"] = (float)(airStats.offChannelTotalMs / 1000.0);
+    air["tokensMs"] = airStats.tokensMs;
+    air["deferredScans"] = airStats.deferred;
     
     // Calculate uptime
     if (wifiConnectedTime > 0 && WiFi.status() == WL_CONNECTED) {
@@ -1629,94 +3175,354 @@ String RoamingWiFiManager::getWiFiStatus() {
     } else {
         doc["uptime"] = "Not connected";
     }
-    
-    String result;
-    serializeJson(doc, result);
-    return result;
+    
+    String result;
+    serializeJson(doc, result);
+    return result;
+}
+
+String RoamingWiFiManager::getPasswordOfNetwork(String ssid) {
+    const int index = knownSsids.find(ssid.c_str());
+    if (index < 0) {
+        return "";
+    }
+    return knownNetworks[(size_t)index].password;
+}
+
+void RoamingWiFiManager::scanNetworksFullAsync() {
+    removeSweepJobs();
+    autoRescanActive = false;
+    autoRescanIndex = 0;
+    autoRescanTargetBssid = 0;
+    autoRescanTargetChannel = 0;
+    autoRescanSweepDidScan = false;
+
+    if (!scanInProgress) {
+        scanInProgress = true;
+        lastScanStartTime = millis();
+        WiFi.scanNetworks(true); // Async scan (all channels)
+        LED(25, 0, 50); // magenta: scan in progress
+    } else {
+        DBG_PRINTLN_L(2,"WiFi: Scan already in progress; cannot start another.");
+    }
+}
+
+void RoamingWiFiManager::applyScanHomeDwell() {
+    // WiFi.scanNetworks() leaves home_chan_dwell_time of its scan config at 0, so the driver takes it from the
+    // default scan parameters. The driver accepts 30..150 ms; 30 ms is its own default.
+    wifi_scan_default_params_t params;
+    if (esp_wifi_get_scan_parameters(&params) != ESP_OK) {
+        return;
+    }
+    uint32_t dwellMs = 30;
+    if (connection.connected && fullScanConnectedMode == FullScanMode::HomeDwell) {
+        dwellMs = std::min<uint32_t>(fullScanHomeDwellMs, 150);
+    }
+    if (params.home_chan_dwell_time == dwellMs) {
+        return;
+    }
+    params.home_chan_dwell_time = (uint8_t)dwellMs;
+    if (esp_wifi_set_scan_parameters(&params) != ESP_OK) {
+        DBG_PRINTLN_L(2,"WiFi: Could not set the home-channel dwell of full scans.");
+    }
+}
+
+bool RoamingWiFiManager::useChunkedFullScan() const {
+    if (autoRescanTestChannelList.empty()) {
+        return false;
+    }
+    return fullScanProgressive || (directedScans && !knownNetworks.empty()) ||
+        (connection.connected && fullScanConnectedMode == FullScanMode::Chunked);
+}
+
+void RoamingWiFiManager::beginChunkedFullScan(const ScanJob& job) {
+    if (fullScanChunkActive) {
+        DBG_PRINTF_L(3,"WiFi: Restarting chunked full scan for %s\n", toString((ScanPurpose)job.purpose).c_str());
+        scanJobs.remove((uint8_t)ScanPurpose::FullScanChunk);
+    }
+    DBG_PRINTF_L(2,"WiFi: Chunked full scan: %u channels, %u per chunk, %u ms home dwell\n",
+        (unsigned)autoRescanTestChannelList.size(), (unsigned)fullScanChunkChannels, (unsigned)fullScanHomeDwellMs);
+    fullScanChunkActive = true;
+    fullScanChunkPurpose = (ScanPurpose)job.purpose;
+    fullScanChunkPriority = job.priority;
+    fullScanChunkNext = 0;
+    fullScanChunkInBurst = 0;
+    fullScanChunkResumeTime = millis();
+    fullScanChunkStartTime = millis();
+    fullScanChunkStep = 0;
+    fullScanChunkChannelStartMs = millis();
+    fullScanChunkRecords = 0;
+    // One directed step per known SSID (at most ScanJob::NoSsid), plus the undirected one unless filtering
+    fullScanChunkDirected = directedScans && !knownNetworks.empty();
+    fullScanChunkSteps = 1;
+    if (fullScanChunkDirected) {
+        fullScanChunkSteps = std::min(knownNetworks.size(), (size_t)ScanJob::NoSsid) + (directedScanFilter ? 0 : 1);
+        DBG_PRINTF_L(3,"WiFi: Full scan directed at %u known SSIDs%s\n", (unsigned)std::min(knownNetworks.size(), (size_t)ScanJob::NoSsid),
+            directedScanFilter ? ", responses filtered" : "");
+    }
+}
+
+ScanJob RoamingWiFiManager::makeFullScanChunkJob() const {
+    ScanJob job;
+    job.priority = fullScanChunkPriority;
+    job.purpose = (uint8_t)ScanPurpose::FullScanChunk;
+    job.channel = (uint8_t)autoRescanTestChannelList[fullScanChunkNext];
+    if (fullScanChunkDirected && fullScanChunkStep < knownNetworks.size() && fullScanChunkStep < ScanJob::NoSsid) {
+        job.ssidIndex = (uint8_t)fullScanChunkStep;
+    }
+    return job;
+}
+
+void RoamingWiFiManager::advanceChunkedFullScan() {
+    if (!fullScanChunkActive) {
+        return;
+    }
+    if (++fullScanChunkStep < fullScanChunkSteps) {
+        return; // next SSID on the same channel
+    }
+    fullScanChunkStep = 0;
+    fullScanChunkChannelStartMs = millis();
+    if (++fullScanChunkNext >= autoRescanTestChannelList.size()) {
+        DBG_PRINTLN_L(2,"WiFi: Chunked full scan completed, processing results...");
+        fullScanChunkActive = false;
+        lastFullScanRecords = fullScanChunkRecords;
+        enforceApTableLimits();
+        if (!autoRescanActive) {
+            sortNetworks(); // a running sweep relies on positions (autoRescanIndex)
+        }
+        finishFullScan(fullScanChunkPurpose);
+        return;
+    }
+    if (connection.connected && ++fullScanChunkInBurst >= fullScanChunkChannels) {
+        // Back on the home channel for a while before the next chunk
+        fullScanChunkInBurst = 0;
+        fullScanChunkResumeTime = millis() + fullScanHomeDwellMs;
+    }
+}
+
+void RoamingWiFiManager::publishFullScanChunk() {
+    lastNetworksScanTime = millis();
+    lastNetworksScanType = "partial";
+    if (connection.connected) {
+        handleAutoRoaming();
+    } else if (fullScanChunkPurpose == ScanPurpose::ReconnectFull && !findBestNetworkVar().isEmpty()) {
+        // Something known turned up: reconnect now, and scan the rest of the band in the background
+        DBG_PRINTLN_L(2,"WiFi: Full scan found a known network, reconnecting before the scan completes.");
+        lastAutoReconnectAttemptTime = 0;
+        fullScanChunkPriority = ScanJobPriority::Discovery;
+    }
+}
+
+void RoamingWiFiManager::finishFullScan(ScanPurpose purpose) {
+    // A complete scan also ends a chunked one that was still going
+    fullScanChunkActive = false;
+    scanJobs.remove((uint8_t)ScanPurpose::FullScanChunk);
+    printNetworks();
+    lastNetworksScanTime = millis();
+    lastAutoFullScanTime = millis();
+    lastNetworksScanType = "full";
+    networkScanCount++;
+    if (purpose != ScanPurpose::AutoFull) {
+        scanJobs.remove((uint8_t)ScanPurpose::AutoFull); // just done
+    }
+    if (purpose == ScanPurpose::ReconnectFull) {
+        lastAutoReconnectAttemptTime = 0; // try the fresh results right away
+    }
+    scanPurpose = ScanPurpose::None;
+}
+
+void RoamingWiFiManager::scanNetworkAsync(uint8_t channel, const uint8_t* bssid, const char* ssid) {
+    if (scanInProgress) {
+        DBG_PRINTLN_L(2,"WiFi: Scan already in progress; cannot start another.");
+        return;
+    }
+
+    scanInProgress = true;
+    lastScanStartTime = millis();
+    if (autoRescanActive && isSweepPurpose(scanPurpose)) {
+        if (autoRescanSweepScans == 0) {
+            autoRescanSweepStartTime = lastScanStartTime;
+        }
+        autoRescanSweepScans++;
+    }
+
+    // Select scan time: learned for this channel (and BSSID), or based on whether channel is DFS or not
+    const int targetPos = (bssid != nullptr) ? findNetworkIndex(bssidToKey(bssid)) : -1;
+    const uint32_t scanTimeMs = (ssid != nullptr) ? directedScanDwellMs :
+        dwellTimeMs(channel, targetPos >= 0 ? &scannedNetworkList[(size_t)targetPos] : nullptr);
+    lastScanDwellMs = (uint16_t)scanTimeMs;
+
+    // Scan one channel only, a specific SSID and/or BSSID (may be null).
+    WiFi.scanNetworks(true, true, false, scanTimeMs, channel, ssid, bssid);
+    LED(25, 0, 50); // magenta: scan in progress
+}
+
+bool RoamingWiFiManager::isKnownSsid(const char* ssid) {
+    return knownSsids.find(ssid) >= 0;
+}
+
+bool RoamingWiFiManager::isRescanEligible(ScannedNetwork& candidate, bool markSkipped) {
+    // The connected AP's RSSI is sampled without scanning
+    if (connectedRssiSampleMs != 0 && connection.connected && candidate.bssidKey() == connection.bssidKey) {
+        return false;
+    }
+
+    // Skip if we're only scanning known networks and this one is unknown
+    if (autoRescanKnownOnly && !candidate.isKnown()) {
+        if (markSkipped) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan skipping unknown network %s\n", candidate.ssid);
+            candidate.scanned = false;
+        }
+        return false;
+    }
+
+    // Skip if a channel-grouped sweep already scanned this entry's channel
+    if (autoRescanSweepByChannel && (autoRescanSweepChannels[candidate.channel >> 5] & (1u << (candidate.channel & 31)))) {
+        return false;
+    }
+
+    // Skip if another BSSID of the same radio was already rescanned in this sweep
+    if (autoRescanGroupRadios && candidate.sweepRefreshed) {
+        if (markSkipped) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan skipping %s (BSSID: %s), radio already rescanned\n",
+                candidate.ssid, candidate.bssidStr().c_str());
+            autoRescanSharedRadioSkipCount++;
+        }
+        return false;
+    }
+
+    // Skip if we're skipping non-detected networks and this one is not detected
+    // BUT: never skip the currently connected network
+    if (autoRescanSkipNotDetected && !candidate.detected) {
+        // Check if this is the currently connected network
+        const bool isCurrentlyConnected = candidate.bssidKey() == getConnectedBssidKey();
+
+        if (!isCurrentlyConnected) {
+            if (markSkipped) {
+                DBG_PRINTF_L(3,"WiFi: Auto-rescan skipping non-detected network %s (BSSID: %s)\n",
+                    candidate.ssid, candidate.bssidStr().c_str());
+                candidate.scanned = false;
+            }
+            return false;
+        } else if (markSkipped) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan keeping currently connected network %s (BSSID: %s) despite not detected\n",
+                candidate.ssid, candidate.bssidStr().c_str());
+        }
+    }
+
+    // This entry is eligible for scanning
+    return true;
 }
 
-String RoamingWiFiManager::getPasswordOfNetwork(String ssid) {
-    for (const NetworkCredentials& net : knownNetworks) {
-        if (net.ssid.equals(ssid)) {
-            return net.password;
+size_t RoamingWiFiManager::selectDueRescanEntry() {
+    const uint32_t now = millis();
+    size_t best = scannedNetworkList.size();
+    int32_t bestOverdue = -1;
+    for (size_t i = 0; i < scannedNetworkList.size(); i++) {
+        ScannedNetwork& entry = scannedNetworkList[i];
+        const int32_t overdue = (int32_t)(now - entry.nextRescanMs);
+        if (overdue <= bestOverdue || !isRescanEligible(entry, false)) {
+            continue;
         }
+        best = i;
+        bestOverdue = overdue;
     }
-    return "";
+    return best;
 }
 
-void RoamingWiFiManager::scanNetworksFullAsync() {
-    autoRescanActive = false;
-    autoRescanIndex = 0;
-    autoRescanTargetBssid = "";
-    autoRescanTargetChannel = 0;
-    autoRescanSweepDidScan = false;
+uint32_t RoamingWiFiManager::rescanIntervalMs(const ScannedNetwork& entry) const {
+    const float minMs = autoRescanMinIntervalSec * 1000.0f;
+    const float maxMs = autoRescanMaxIntervalSec * 1000.0f;
+    if (!entry.detected) {
+        // Gone (for now): check less often the longer it has been missing, up to 8x the max interval
+        const float missingSec = (float)(millis() - entry.lastSeenMs) / 1000.0f;
+        return (uint32_t)(maxMs * std::min(8.0f, 1.0f + missingSec / 60.0f));
+    }
 
-    if (!scanInProgress) {
-        scanInProgress = true;
-        WiFi.scanNetworks(true); // Async scan (all channels)
-        LED(25, 0, 50); // magenta: scan in progress
-    } else {
-        DBG_PRINTLN_L(2,"WiFi: Scan already in progress; cannot start another.");
+    // Urgency 0..1: RSSI volatility (6 dB mean change counts as fully volatile) ...
+    float urgency = std::min(1.0f, (float)entry.rssiVolatility / 4.0f / 6.0f);
+
+    // ... or closeness to the roam threshold for entries that could become roam targets
+    const bool roamCandidate = connection.connected && entry.isKnown() &&
+        entry.radioKey() != radioKeyOf(connection.bssidKey, connection.channel) &&
+        (!autoRoamSameSsidOnly || entry.credentialIndex() == connection.credentialIndex);
+    if (roamCandidate) {
+        const float thresholdDbm = (float)connection.rssi + autoRoamDeltaRssiDbm;
+        const float marginDb = fabsf((float)entry.rssi - thresholdDbm);
+        urgency = std::max(urgency, 1.0f - std::min(1.0f, marginDb / RescanRoamMarginWindowDb));
     }
+    return (uint32_t)(maxMs - (maxMs - minMs) * urgency);
 }
 
-bool RoamingWiFiManager::isDfsChannel(uint8_t channel) {
-    // DFS channels in 5GHz band: 52-64, 100-144
-    // Non-DFS 5GHz channels: 36, 40, 44, 48, 149, 153, 157, 161, 165, 169, 173, 177
-    return (channel >= 52 && channel <= 64) || (channel >= 100 && channel <= 144);
+void RoamingWiFiManager::scheduleRescan(ScannedNetwork& entry) {
+    entry.nextRescanMs = millis() + rescanIntervalMs(entry);
 }
 
-void RoamingWiFiManager::scanNetworkAsync(uint8_t channel, const uint8_t* bssid) {
-    if (scanInProgress) {
-        DBG_PRINTLN_L(2,"WiFi: Scan already in progress; cannot start another.");
-        return;
+uint16_t RoamingWiFiManager::dwellTimeMs(uint8_t channel, const ScannedNetwork* target) const {
+    const uint16_t configuredMs = (uint16_t)(isDfsChannel(channel) ? scanTimeDfsMs : scanTimeNonDfsMs);
+    if (!adaptiveDwell) {
+        return configuredMs;
     }
+    uint32_t ms = channelDwell.dwellFor(channel, configuredMs);
+    if (target != nullptr && target->dwellBoost) {
+        ms = std::min(dwellMaxMs, ms * 2); // this BSSID was just missed although present
+    }
+    return (uint16_t)ms;
+}
 
-    scanInProgress = true;
-
-    // Select scan time based on whether channel is DFS or not
-    uint32_t scanTimeMs = isDfsChannel(channel) ? scanTimeDfsMs : scanTimeNonDfsMs;
-
-    // Scan one channel only, a specific BSSID (may be null).
-    WiFi.scanNetworks(true, true, false, scanTimeMs, channel, nullptr, bssid);
-    LED(25, 0, 50); // magenta: scan in progress
+void RoamingWiFiManager::noteDwellOutcome(uint8_t channel, bool hit) {
+    if (!adaptiveDwell) {
+        return;
+    }
+    if (hit) {
+        channelDwell.recordHit(channel, lastScanDwellMs);
+    } else {
+        channelDwell.recordEmpty(channel, lastScanDwellMs);
+    }
 }
 
-static bool parseBssidStr(const String& bssidStr, uint8_t outBssid[6]) {
-    if (bssidStr.length() < 17) {
-        return false;
+void RoamingWiFiManager::noteDwellMiss(ScannedNetwork& entry) {
+    if (!adaptiveDwell) {
+        return;
+    }
+    if (entry.bssidKey() == getConnectedBssidKey()) {
+        // We are associated with it, so it certainly was there
+        noteFalseEmpty(entry);
+    } else if (entry.detected) {
+        entry.missPending = 1; // confirmed as a false empty if it is heard again soon, see updateNetworkFromRecord()
     }
-    return (sscanf(bssidStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-        &outBssid[0], &outBssid[1], &outBssid[2], &outBssid[3], &outBssid[4], &outBssid[5]) == 6);
 }
 
-bool RoamingWiFiManager::isKnownSsid(const String& ssid) {
-    if (ssid.length() == 0) {
-        return false;
+void RoamingWiFiManager::noteFalseEmpty(ScannedNetwork& entry) {
+    channelDwell.recordFalseEmpty(entry.channel, lastScanDwellMs);
+    entry.dwellBoost = 1;
+    if (entry.falseEmpties < 255) {
+        entry.falseEmpties++;
     }
-    for (const NetworkCredentials& net : knownNetworks) {
-        if (net.ssid.equals(ssid)) {
-            return true;
-        }
+    DBG_PRINTF_L(3,"WiFi: Dwell on channel %u missed %s although present, dwell now %u ms\n",
+        (unsigned)entry.channel, entry.bssidStr().c_str(), (unsigned)channelDwell.dwellFor(entry.channel, lastScanDwellMs));
+}
+
+uint32_t RoamingWiFiManager::autoRescanWaitRemainingMs() const {
+    if (autoRescanKnownIntervalSec <= 0.0f || lastAutoRescanSingleScanTime == 0) {
+        return 0;
     }
-    return false;
+    const unsigned long waitMs = (unsigned long)(autoRescanKnownIntervalSec * 1000.0f);
+    const unsigned long elapsedMs = millis() - lastAutoRescanSingleScanTime;
+    return (elapsedMs < waitMs) ? (uint32_t)(waitMs - elapsedMs) : 0;
 }
 
-bool RoamingWiFiManager::startAutoRescanNext(bool knownOnly) {
-    if (scanInProgress) {
-        return false;
+bool RoamingWiFiManager::startAutoRescanNext(bool knownOnly, ScanJobPriority priority) {
+    if (sweepJobPending()) {
+        return false; // one step of a sweep at a time
     }
 
     // Check if we need to wait before starting the next scan
-    if (autoRescanKnownIntervalSec > 0.0f && lastAutoRescanSingleScanTime > 0) {
-        unsigned long waitMs = (unsigned long)(autoRescanKnownIntervalSec * 1000.0f);
-        unsigned long elapsedMs = millis() - lastAutoRescanSingleScanTime;
-        if (elapsedMs < waitMs) {
-            // Not enough time has passed, don't start next scan yet
-            DBG_PRINTF_L(4,"WiFi: Auto-rescan waiting %.2f sec before next scan\n",
-                (double)((waitMs - elapsedMs) / 1000.0f));
-            return false;
-        }
+    const uint32_t waitMs = autoRescanWaitRemainingMs();
+    if (waitMs > 0) {
+        // Not enough time has passed, don't start next scan yet
+        DBG_PRINTF_L(4,"WiFi: Auto-rescan waiting %.2f sec before next scan\n", (double)(waitMs / 1000.0f));
+        return false;
     }
 
     if (!autoRescanActive) { // it was not active, so initialize with first entry
@@ -1724,114 +3530,362 @@ bool RoamingWiFiManager::startAutoRescanNext(bool knownOnly) {
         autoRescanIndex = 0;
         autoRescanSweepDidScan = false;
         autoRescanKnownOnly = knownOnly;
+        autoRescanSweepJobPriority = priority;
+        autoRescanSweepByChannel = autoRescanByChannel;
+        autoRescanSweepPriority = autoRescanPriority;
+        memset(autoRescanSweepChannels, 0, sizeof(autoRescanSweepChannels));
+        autoRescanTestChannelDone = false;
+        autoRescanSweepScans = 0;
+        autoRescanSweepRadioMs = 0;
+        for (auto& entry : scannedNetworkList) {
+            entry.sweepRefreshed = 0;
+        }
 
         // New sweep: do NOT clear scanned for eligible entries (known networks), because the UI may query
         // mid-sweep and we don't want to briefly report known networks as "not scanned".
         // Instead, only mark entries that are ineligible for this sweep as scanned=false.
         if (autoRescanKnownOnly) {
             for (auto& entry : scannedNetworkList) {
-                if (!isKnownSsid(entry.ssid)) {
+                if (!entry.isKnown()) {
                     entry.scanned = false;
                 }
             }
         }
+        if (autoRescanSweepPriority) {
+            // The scheduler does not walk the list, so apply the skip marks once per sweep
+            for (auto& entry : scannedNetworkList) {
+                isRescanEligible(entry, true);
+            }
+        }
     }
 
-    // Skip entries that are not eligible for this sweep.
-    while (autoRescanIndex < scannedNetworkList.size()) {
-        const ScannedNetwork& candidate = scannedNetworkList[autoRescanIndex];
-        
-        // Skip if we're only scanning known networks and this one is unknown
-        if (autoRescanKnownOnly && !isKnownSsid(candidate.ssid)) {
-            DBG_PRINTF_L(3,"WiFi: Auto-rescan skipping unknown network %s\n", candidate.ssid.c_str());
-            scannedNetworkList[autoRescanIndex].scanned = false;
-            autoRescanIndex++;
-            continue;
-        }
-        
-        // Skip if we're skipping non-detected networks and this one is not detected
-        // BUT: never skip the currently connected network
-        if (autoRescanSkipNotDetected && !candidate.detected) {
-            // Check if this is the currently connected network
-            const bool isConnected = (WiFi.status() == WL_CONNECTED);
-            const String currentBssid = isConnected ? WiFi.BSSIDstr() : "";
-            const bool isCurrentlyConnected = isConnected && candidate.bssid.equalsIgnoreCase(currentBssid);
-            
-            if (!isCurrentlyConnected) {
-                DBG_PRINTF_L(3,"WiFi: Auto-rescan skipping non-detected network %s (BSSID: %s)\n", 
-                    candidate.ssid.c_str(), candidate.bssid.c_str());
-                scannedNetworkList[autoRescanIndex].scanned = false;
+    // Queue the scan of the next eligible entry; entries that cannot be scanned are passed over here
+    for (;;) {
+        if (autoRescanSweepPriority) {
+            autoRescanIndex = selectDueRescanEntry();
+            if (autoRescanIndex >= scannedNetworkList.size() && !autoRescanSweepDidScan) {
+                // Nothing is due yet; don't start a sweep (and no end-of-sweep work either). Discovery keeps
+                // going though: a test channel is still scanned once per wait interval, as between linear sweeps,
+                // also when no entry is eligible at all (e.g. only the sampled connected AP is known).
+                const bool testChannelDue = autoRescanTestChannels && !autoRescanTestChannelDone &&
+                    (lastTestChannelTime == 0 || millis() - lastTestChannelTime >= (unsigned long)(autoRescanWaitIntervalSec * 1000.0f));
+                if (!testChannelDue) {
+                    autoRescanActive = false;
+                    autoRescanIndex = 0;
+                    return false;
+                }
+            }
+        } else {
+            // Skip entries that are not eligible for this sweep.
+            while (autoRescanIndex < scannedNetworkList.size() && !isRescanEligible(scannedNetworkList[autoRescanIndex], true)) {
                 autoRescanIndex++;
-                continue;
-            } else {
-                DBG_PRINTF_L(3,"WiFi: Auto-rescan keeping currently connected network %s (BSSID: %s) despite not detected\n", 
-                    candidate.ssid.c_str(), candidate.bssid.c_str());
             }
         }
-        
-        // This entry is eligible for scanning
-        break;
-    }
 
-    if (autoRescanIndex >= scannedNetworkList.size()) {
-        if (scanPurpose == ScanPurpose::AutoRescanSingle && autoRescanTestChannels) {
-            // we are beyond the list, but we are testing channels, so restart from beginning
-            if (autoRescanTestChannelIndex < 0) {
-                autoRescanTestChannelIndex = 0;
-            } else {
-                autoRescanTestChannelIndex = (autoRescanTestChannelIndex + 1) % autoRescanTestChannelList.size();
+        if (autoRescanIndex >= scannedNetworkList.size()) {
+            if (autoRescanTestChannels && !autoRescanTestChannelDone) {
+                // we are beyond the list, so test one more channel before the sweep ends
+                autoRescanTestChannelIndex = selectTestChannel();
+                autoRescanTestChannelDone = true;
+                lastTestChannelTime = millis();
+                ScanJob job;
+                job.priority = ScanJobPriority::Discovery;
+                job.purpose = (uint8_t)ScanPurpose::AutoRescanTestChannel;
+                job.channel = (uint8_t)autoRescanTestChannelList[(size_t)autoRescanTestChannelIndex];
+                DBG_PRINTF_L(4,"WiFi: Auto-rescan test channel %d\n", (int)job.channel);
+                enqueueScanJob(job);
+                return true;
             }
-            autoRescanTargetChannel = autoRescanTestChannelList[autoRescanTestChannelIndex];
-            DBG_PRINTF_L(4,"WiFi: Auto-rescan test channel %d\n", autoRescanTargetChannel);
-            autoRescanTargetBssid = "";
-            scanPurpose = ScanPurpose::AutoRescanTestChannel;
-            scanNetworkAsync(autoRescanTargetChannel, nullptr);
-            return true;
-        } else {
             // we are beyond the list, so we re-scanned everything, so we are done
             if (autoRescanSweepDidScan) {
                 networkScanCount++;
                 DBG_PRINTF_L(3,"WiFi: Auto-rescan complete, networkScanCount=%d\n", networkScanCount);
+                finishRescanSweepStats();
             }
             autoRescanActive = false;
             autoRescanIndex = 0;
-            autoRescanTargetBssid = "";
+            autoRescanTargetBssid = 0;
             autoRescanTargetChannel = 0;
             autoRescanSweepDidScan = false;
             autoRescanKnownOnly = false;
-            scanPurpose = ScanPurpose::None;
+            enforceApTableLimits();
             sortNetworks();
             return false;
         }
+
+        ScannedNetwork& target = scannedNetworkList[autoRescanIndex];
+        if (autoRescanSweepPriority) {
+            scheduleRescan(target); // not due again until its next interval, whatever the outcome
+        }
+        if (target.bssidKey() == 0 || target.channel == 0) {
+            // Bad entry; cannot rescan it. Keep it but mark as not detected for this sweep.
+            target.scanned = false;
+            target.detected = false;
+            noteNetworkChanged(target);
+            autoRescanIndex++;
+            lastNetworksScanTime = millis();
+            continue;
+        }
+
+        ScanJob job;
+        job.priority = autoRescanSweepJobPriority;
+        job.channel = target.channel;
+        job.bssidKey = target.bssidKey();
+        if (autoRescanSweepByChannel) {
+            // One scan without BSSID filter refreshes every entry on this channel
+            job.purpose = (uint8_t)ScanPurpose::AutoRescanChannel;
+            autoRescanSweepChannels[target.channel >> 5] |= 1u << (target.channel & 31);
+            DBG_PRINTF_L(3,"WiFi: Auto-scan rescan %s (%u/%u): channel=%u\n",
+                autoRescanKnownOnly ? "known" : "existing",
+                (unsigned)(autoRescanIndex + 1),
+                (unsigned)scannedNetworkList.size(),
+                (unsigned)target.channel);
+        } else {
+            job.purpose = (uint8_t)ScanPurpose::AutoRescanSingle;
+            job.filterBssid = true;
+            DBG_PRINTF_L(3,"WiFi: Auto-scan rescan %s (%u/%u): BSSID=%s channel=%u\n",
+                autoRescanKnownOnly ? "known" : "existing",
+                (unsigned)(autoRescanIndex + 1),
+                (unsigned)scannedNetworkList.size(),
+                target.bssidStr().c_str(),
+                (unsigned)target.channel);
+        }
+        enqueueScanJob(job);
+        return true;
     }
+}
 
-    const ScannedNetwork& target = scannedNetworkList[autoRescanIndex];
-    autoRescanTargetBssid = target.bssid;
-    autoRescanTargetChannel = target.channel;
+bool RoamingWiFiManager::isSweepPurpose(ScanPurpose purpose) {
+    return purpose == ScanPurpose::AutoRescanSingle || purpose == ScanPurpose::AutoRescanChannel ||
+        purpose == ScanPurpose::AutoRescanTestChannel;
+}
 
-    uint8_t bssid[6];
-    if (!parseBssidStr(autoRescanTargetBssid, bssid) || autoRescanTargetChannel == 0) {
-        // Bad entry; cannot rescan it. Keep it but mark as not detected for this sweep.
-        scannedNetworkList[autoRescanIndex].scanned = false;
-        scannedNetworkList[autoRescanIndex].detected = false;
-        autoRescanIndex++;
-        lastNetworksScanTime = millis();
-        return startAutoRescanNext(autoRescanKnownOnly); // warning: recursive!
-    }
-
-    scanPurpose = ScanPurpose::AutoRescanSingle;
-    DBG_PRINTF_L(3,"WiFi: Auto-scan rescan %s (%u/%u): BSSID=%s channel=%u\n",
-        autoRescanKnownOnly ? "known" : "existing",
-        (unsigned)(autoRescanIndex + 1),
-        (unsigned)scannedNetworkList.size(),
-        autoRescanTargetBssid.c_str(),
-        (unsigned)autoRescanTargetChannel);
-    lastAutoRescanSingleScanTime = millis();
-    scanNetworkAsync(autoRescanTargetChannel, bssid);
-    autoRescanSweepDidScan = true;
+bool RoamingWiFiManager::scanJobPending(ScanPurpose purpose) const {
+    return (scanInProgress && scanPurpose == purpose) || scanJobs.contains((uint8_t)purpose);
+}
+
+bool RoamingWiFiManager::sweepJobPending() const {
+    return scanJobPending(ScanPurpose::AutoRescanSingle) || scanJobPending(ScanPurpose::AutoRescanChannel) ||
+        scanJobPending(ScanPurpose::AutoRescanTestChannel);
+}
+
+void RoamingWiFiManager::enqueueScanJob(ScanJob job) {
+    job.enqueuedMs = millis();
+    if (!scanJobs.push(job)) {
+        DBG_PRINTF_L(2,"WiFi: Scan queue full; dropped %s job (%s)\n", ::toString(job.priority), toString((ScanPurpose)job.purpose).c_str());
+        return;
+    }
+    DBG_PRINTF_L(4,"WiFi: Queued %s job (%s), queue depth %u\n", ::toString(job.priority), toString((ScanPurpose)job.purpose).c_str(),
+        (unsigned)scanJobs.size());
+}
+
+void RoamingWiFiManager::resetRescanSweep() {
+    autoRescanActive = false;
+    autoRescanIndex = 0;
+    autoRescanTargetBssid = 0;
+    autoRescanTargetChannel = 0;
+    autoRescanKnownOnly = false;
+    removeSweepJobs();
+    if (isSweepPurpose(scanPurpose)) {
+        scanPurpose = ScanPurpose::None;
+    }
+}
+
+void RoamingWiFiManager::handleScanRequests() {
+    if (sweepResetRequested) {
+        sweepResetRequested = false;
+        resetRescanSweep();
+    }
+    if (manualRescanRequested) {
+        manualRescanRequested = false;
+        // Only rescan existing networks: restart the sweep at manual priority
+        autoRescanActive = false;
+        removeSweepJobs();
+        if (startAutoRescanNext(false, ScanJobPriority::Manual)) {
+            DBG_PRINTLN_L(2,"/wifi/scan: rescan of existing networks queued");
+        } else {
+            DBG_PRINTLN_L(2,"/wifi/scan: scan already in progress or nothing to rescan");
+        }
+    }
+    if (manualFullScanRequested) {
+        manualFullScanRequested = false;
+        // Full scan across all channels, async; preempts automatic scans.
+        ScanJob job;
+        job.priority = ScanJobPriority::Manual;
+        job.purpose = (uint8_t)ScanPurpose::ManualFull;
+        enqueueScanJob(job);
+        DBG_PRINTLN_L(2,"/wifi/scan: manual full async scan queued");
+    }
+}
+
+void RoamingWiFiManager::removeSweepJobs() {
+    scanJobs.remove((uint8_t)ScanPurpose::AutoRescanSingle);
+    scanJobs.remove((uint8_t)ScanPurpose::AutoRescanChannel);
+    scanJobs.remove((uint8_t)ScanPurpose::AutoRescanTestChannel);
+}
+
+void RoamingWiFiManager::preemptScan(ScanJobPriority priority) {
+    if (!scanInProgress || scanAbortRequested || runningScanJob.priority < ScanJobPriority::Rescan || priority >= runningScanJob.priority) {
+        return;
+    }
+    if (esp_wifi_scan_stop() != ESP_OK) {
+        return;
+    }
+    DBG_PRINTF_L(2,"WiFi: Preempting %s scan (%s) for a %s job\n", ::toString(runningScanJob.priority),
+        toString(scanPurpose).c_str(), ::toString(priority));
+    scanAbortRequested = true;
+    scanAbortTime = millis();
+    scanPreemptedCount++;
+}
+
+bool RoamingWiFiManager::startScanJob(const ScanJob& job) {
+    const ScanPurpose purpose = (ScanPurpose)job.purpose;
+    if (isSweepPurpose(purpose)) {
+        if (!autoRescanActive) {
+            return false; // the sweep was cancelled while this step waited
+        }
+        if (purpose != ScanPurpose::AutoRescanTestChannel) {
+            // Positions may have changed while the job waited, so find the entry again
+            const int pos = findNetworkIndex(job.bssidKey);
+            if (pos < 0) {
+                return false; // evicted meanwhile; the sweep continues with its next entry
+            }
+            autoRescanIndex = (size_t)pos;
+            lastAutoRescanSingleScanTime = millis();
+            autoRescanSweepDidScan = true;
+        }
+        autoRescanTargetBssid = job.filterBssid ? job.bssidKey : 0;
+        autoRescanTargetChannel = job.channel;
+    }
+    if (purpose == ScanPurpose::FullScanChunk && !fullScanChunkActive) {
+        return false; // the chunked scan was ended by a complete one while this chunk waited
+    }
+    if (job.channel == 0 && useChunkedFullScan()) {
+        // Split the sweep into single-channel jobs; the first one runs right away in place of this job
+        beginChunkedFullScan(job);
+        ScanJob chunk = makeFullScanChunkJob();
+        chunk.enqueuedMs = job.enqueuedMs;
+        return startScanJob(chunk);
+    }
+
+    scanJobs.noteStarted(job, millis());
+    runningScanJob = job;
+    scanPurpose = purpose;
+    scanOffChannel = connection.connected && (job.channel == 0 || job.channel != connection.channel);
+    if (job.channel == 0) {
+        applyScanHomeDwell();
+        scanNetworksFullAsync();
+    } else {
+        uint8_t bssid[6];
+        bssidFromKey(job.bssidKey, bssid);
+        const bool directed = job.ssidIndex != ScanJob::NoSsid && job.ssidIndex < knownNetworks.size();
+        scanNetworkAsync(job.channel, job.filterBssid ? bssid : nullptr, directed ? knownNetworks[job.ssidIndex].ssid.c_str() : nullptr);
+    }
     return true;
 }
 
+bool RoamingWiFiManager::dispatchScanJobs() {
+    if (scanInProgress) {
+        // Preempt a running low-priority scan when something more urgent waits
+        const ScanJob* next = scanJobs.peek();
+        if (next != nullptr) {
+            preemptScan(next->priority);
+        }
+        return false;
+    }
+
+    // An active sweep queues its next step once the previous one is done (no recursion)
+    if (autoRescanActive && autoRescanWaitRemainingMs() == 0) {
+        startAutoRescanNext(autoRescanKnownOnly);
+    }
+    // A chunked full scan queues its next channel once the radio has been home long enough
+    // and no connect attempt is settling (a scan would make it fail)
+    if (fullScanChunkActive && !scanJobs.contains((uint8_t)ScanPurpose::FullScanChunk) &&
+        (long)(millis() - fullScanChunkResumeTime) >= 0 &&
+        (lastConnectAttemptTime == 0 || millis() - lastConnectAttemptTime >= FullScanConnectHoldMs)) {
+        enqueueScanJob(makeFullScanChunkJob());
+    }
+
+    const ScanJob* next;
+    while ((next = scanJobs.peek()) != nullptr) {
+        // Background scans wait until they fit the off-channel airtime budget
+        const bool atEdge = rssiEventScanning && connection.connected && linkLevel == LinkLevel::Edge;
+        if (next->priority >= ScanJobPriority::Rescan && !atEdge && !airtime.allows(millis(), scanJobAirtimeMs(*next))) {
+            if (!airtimeDeferring) {
+                airtimeDeferring = true;
+                airtime.noteDeferred();
+                DBG_PRINTF_L(4,"WiFi: %s scan deferred by the airtime budget\n", toString((ScanPurpose)next->purpose).c_str());
+            }
+            return false;
+        }
+        ScanJob job;
+        scanJobs.pop(job);
+        if (startScanJob(job)) {
+            airtimeDeferring = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RoamingWiFiManager::handleAirtimeBudget() {
+    if (airtimeConfigPending) {
+        airtimeConfigPending = false;
+        airtime.configure(airtimeBudgetPercent, airtimeWindowMs);
+    }
+    const AirtimeBudget::Stats stats = airtime.stats(millis());
+    portENTER_CRITICAL(&airtimeStatsMux);
+    airtimeStats = stats;
+    portEXIT_CRITICAL(&airtimeStatsMux);
+}
+
+uint32_t RoamingWiFiManager::scanJobAirtimeMs(const ScanJob& job) const {
+    if (!connection.connected || (job.channel != 0 && job.channel == connection.channel)) {
+        return 0;
+    }
+    if (job.channel == 0) {
+        // A chunked full scan only needs room for its first chunk; later chunks are jobs of their own
+        return useChunkedFullScan() ? dwellTimeMs((uint8_t)autoRescanTestChannelList[0], nullptr) : lastFullScanDurationMs;
+    }
+    if (job.ssidIndex != ScanJob::NoSsid) {
+        return directedScanDwellMs;
+    }
+    const int pos = job.filterBssid ? findNetworkIndex(job.bssidKey) : -1;
+    return dwellTimeMs(job.channel, pos >= 0 ? &scannedNetworkList[(size_t)pos] : nullptr);
+}
+
+void RoamingWiFiManager::noteScanEnded() {
+    const uint32_t durationMs = (uint32_t)(millis() - lastScanStartTime);
+    if (scanOffChannel) {
+        airtime.charge(millis(), durationMs);
+        scanOffChannel = false;
+    }
+    if (runningScanJob.channel == 0 && !scanAbortRequested) {
+        lastFullScanDurationMs = durationMs;
+    }
+}
+
+void RoamingWiFiManager::finishRescanSweepStats() {
+    RescanSweepStats& stats = rescanSweepStats[autoRescanSweepByChannel ? 1 : 0];
+    stats.lastDurationMs = (uint32_t)(millis() - autoRescanSweepStartTime);
+    stats.lastRadioMs = autoRescanSweepRadioMs;
+    stats.lastScans = autoRescanSweepScans;
+    stats.sweeps++;
+    stats.avgDurationMs += ((float)stats.lastDurationMs - stats.avgDurationMs) / (float)stats.sweeps;
+    stats.avgRadioMs += ((float)stats.lastRadioMs - stats.avgRadioMs) / (float)stats.sweeps;
+
+    const RescanSweepStats& other = rescanSweepStats[autoRescanSweepByChannel ? 0 : 1];
+    DBG_PRINTF_L(3,"WiFi: Auto-rescan sweep (%s): %u ms, %u scans, %u ms scanning; average %.0f ms / %.0f ms scanning over %u sweeps\n",
+        autoRescanSweepByChannel ? "per channel" : "per BSSID",
+        (unsigned)stats.lastDurationMs, (unsigned)stats.lastScans, (unsigned)stats.lastRadioMs,
+        (double)stats.avgDurationMs, (double)stats.avgRadioMs, (unsigned)stats.sweeps);
+    if (other.sweeps > 0) {
+        DBG_PRINTF_L(3,"WiFi: Auto-rescan sweep (%s) for comparison: average %.0f ms / %.0f ms scanning over %u sweeps\n",
+            autoRescanSweepByChannel ? "per BSSID" : "per channel",
+            (double)other.avgDurationMs, (double)other.avgRadioMs, (unsigned)other.sweeps);
+    }
+}
+
 void RoamingWiFiManager::resetWiFiSta() {
     DBG_PRINTLN_L(2,"WiFi: Resetting WiFi STA mode...");
     WiFi.disconnect();
@@ -1842,53 +3896,75 @@ void RoamingWiFiManager::resetWiFiSta() {
     WiFi.setBandMode(WIFI_BAND_MODE_5G_ONLY);
 }
 
-void RoamingWiFiManager::handleAutoRoaming() {
+bool RoamingWiFiManager::handleAutoRoaming() {
     // When connected, optionally roam to a stronger network if enabled
-    if (WiFi.status() != WL_CONNECTED || !autoRoamEnabled || scanInProgress) {
-        return;
+    if (WiFi.status() != WL_CONNECTED || !autoRoamEnabled) {
+        return false;
     }
 
     const long cooldownMs = (long)(autoReconnectIntervalSec * 1000.0f);
     if (lastConnectAttemptTime != 0 && (millis() - lastConnectAttemptTime) < cooldownMs) {
-        return;
+        return false;
     }
 
-    const String curSsid = WiFi.SSID();
-    const String curBssid = WiFi.BSSIDstr();
-    const int curRssi = WiFi.RSSI();
+    const uint64_t curRadio = radioKeyOf(getConnectedBssidKey(), connection.channel);
+    // The current AP is judged by its filtered RSSI too, so a single faded sample doesn't trigger a roam.
+    // Its table entry follows the driver's samples when connectedRssiSampleMs is on, else the scans.
+    const int curPos = findNetworkIndex(getConnectedBssidKey());
+    int curRssi = getConnectedRssi();
+    if (curPos >= 0 && scannedNetworkList[(size_t)curPos].detected) {
+        curRssi = scannedNetworkList[(size_t)curPos].smoothedRssi();
+    }
 
-    int bestIdx = -1;
-    int bestRssi = -1000;
+    // Best scored detected candidate on another radio than the current one.
+    // Candidates are known networks only; a same-SSID roam needs the connected SSID to be known too.
+    refreshRoamCandidates();
+    const RoamCandidates::Candidate* best = nullptr;
+    if (autoRoamSameSsidOnly) {
+        best = roamCandidates.best(connection.credentialIndex, curRadio);
+    } else {
+        best = roamCandidates.bestOverall(curRadio);
+    }
 
-    for (int i = 0; i < (int)scannedNetworkList.size(); i++) {
-        const ScannedNetwork& n = scannedNetworkList[i];
-        if (!n.detected || !n.scanned) continue;
-        if (n.bssid.equalsIgnoreCase(curBssid)) continue; // same BSSID
-        if (autoRoamSameSsidOnly) {
-            if (!n.ssid.equals(curSsid)) continue;
-        } else {
-            // Only consider known networks when roaming across SSIDs
-            if (!isKnownSsid(n.ssid)) continue;
-        }
+    // Candidate must exceed the current AP by delta. Scores are in dB, so the same delta applies; an AP
+    // missing from the table can't be scored, and is compared by RSSI.
+    const bool scored = curPos >= 0;
+    const int curValue = scored ? scoreNetwork(scannedNetworkList[(size_t)curPos], (int8_t)curRssi).total : curRssi;
+    const int delta = (int)autoRoamDeltaRssiDbm;
+    if (best == nullptr || (scored ? best->score : best->rssi) < curValue + delta) {
+        return false;
+    }
+    const int bestIdx = findNetworkIndex(best->bssidKey);
+    if (bestIdx < 0) {
+        return false;
+    }
 
-        // Candidate must exceed current RSSI by delta
-        const int delta = (int)autoRoamDeltaRssiDbm;
-        if (n.rssi >= curRssi + delta) {
-            if (n.rssi > bestRssi) {
-                bestRssi = n.rssi;
-                bestIdx = i;
-            }
+    const ScannedNetwork& target = scannedNetworkList[bestIdx];
+    if (millis() - target.lastSeenMs > RoamVerifyMaxAgeMs) {
+        // The candidate's RSSI is stale: confirm it with a targeted scan first (preempts automatic scans)
+        if (!scanJobPending(ScanPurpose::RoamVerify)) {
+            DBG_PRINTF_L(3,"WiFi: Auto-roam: verifying candidate %s (RSSI %d, seen %u ms ago)\n",
+                target.bssidStr().c_str(), (int)target.rssi, (unsigned)(millis() - target.lastSeenMs));
+            ScanJob job;
+            job.priority = ScanJobPriority::RoamVerify;
+            job.purpose = (uint8_t)ScanPurpose::RoamVerify;
+            job.channel = target.channel;
+            job.filterBssid = true;
+            job.bssidKey = target.bssidKey();
+            enqueueScanJob(job);
         }
+        return false;
     }
-
-    if (bestIdx >= 0) {
-        const ScannedNetwork& target = scannedNetworkList[bestIdx];
-        DBG_PRINTF_L(2,
-            "WiFi: Auto-roam: switching to stronger network: SSID=%s RSSI=%d (current %d, delta >= %.0f) BSSID=%s ch=%u\n",
-            target.ssid.c_str(), target.rssi, curRssi, (double)autoRoamDeltaRssiDbm, target.bssid.c_str(), (unsigned)target.channel);
-        connectToTargetNetwork(target.ssid, target.bssid, target.channel);
-        lastConnectAttemptTime = millis();
+    if (scanInProgress) {
+        return false;
     }
+    DBG_PRINTF_L(2,
+        "WiFi: Auto-roam: switching to better network: SSID=%s RSSI=%d score=%d (current %d/%d, delta >= %.0f) BSSID=%s ch=%u\n",
+        target.ssid, target.rssi, (int)best->score, curRssi, curValue, (double)autoRoamDeltaRssiDbm,
+        target.bssidStr().c_str(), (unsigned)target.channel);
+    connectToTargetNetwork(target.ssid, target.bssidStr().c_str(), target.channel);
+    lastConnectAttemptTime = millis();
+    return true;
 }
 
 bool RoamingWiFiManager::handleStationDisconnect() {
@@ -1935,8 +4011,7 @@ bool RoamingWiFiManager::handleAutoReconnect() {
         return false;
     }
 
-    // Handle auto-reconnect, unless when currently scanning
-    if (!autoReconnectEnabled || scanInProgress) {
+    if (!autoReconnectEnabled) {
         return false;
     }
 
@@ -1944,6 +4019,11 @@ bool RoamingWiFiManager::handleAutoReconnect() {
     if (lastAutoReconnectAttemptTime != 0 && (millis() - lastAutoReconnectAttemptTime < intervalMs)) {
         return false;
     }
+    if (scanInProgress) {
+        // A reconnect attempt is due: free the radio if only an automatic scan is using it
+        preemptScan(ScanJobPriority::Reconnect);
+        return false;
+    }
 
     lastAutoReconnectAttemptTime = millis();
     autoReconnectAttemptCount++;
@@ -1953,6 +4033,15 @@ bool RoamingWiFiManager::handleAutoReconnect() {
     if (autoReconnectAttemptCount > autoReconnectResetThreshold) {
         autoReconnectAttemptCount = 0;
         resetWiFiSta();
+    } else if (findBestNetworkVar().isEmpty()) {
+        // Nothing known to connect to: a full scan is the most urgent radio job now
+        if (!scanJobPending(ScanPurpose::ReconnectFull)) {
+            DBG_PRINTLN_L(2,"WiFi: Auto-reconnect: no known network in the AP table, queueing a full scan.");
+            ScanJob job;
+            job.priority = ScanJobPriority::Reconnect;
+            job.purpose = (uint8_t)ScanPurpose::ReconnectFull;
+            enqueueScanJob(job);
+        }
     } else {
         connectToStrongestNetwork();
     }
@@ -1966,30 +4055,46 @@ bool RoamingWiFiManager::handleAutomaticScanning() {
         return false;
     }
 
+    bool fullEnabled = autoFullScanEnabled;
+    float fullIntervalSec = autoFullScanIntervalSec;
+    bool rescanEnabled = autoRescanKnownEnabled;
+    bool rescanKnownOnly = autoRescanKnownOnlySetting;
+    if (rssiEventScanning && connection.connected) {
+        // The link level replaces the timers: nothing while the link is good, more the closer to the cell edge
+        const LinkLevel level = updateLinkLevel();
+        fullEnabled = level == LinkLevel::Edge;
+        fullIntervalSec = rssiEdgeFullIntervalSec;
+        rescanEnabled = level != LinkLevel::Good;
+        rescanKnownOnly = true;
+    }
+
     // Start automatic scan (full or rescan) if enabled and time elapsed
-    if (autoFullScanEnabled) {
-        long intervalMs = autoFullScanIntervalSec * 1000;
+    if (fullEnabled) {
+        long intervalMs = fullIntervalSec * 1000;
         if (lastAutoFullScanTime == 0 || (millis() - lastAutoFullScanTime >= intervalMs)) {
             lastAutoFullScanTime = millis();
-            DBG_PRINTLN_L(2,"WiFi: Starting automatic complete network scan...");
-            scanPurpose = ScanPurpose::AutoFull;
-            scanNetworksFullAsync();
-            return true;
+            if (!scanJobPending(ScanPurpose::AutoFull) && !fullScanChunkActive) {
+                DBG_PRINTLN_L(2,"WiFi: Queueing automatic complete network scan...");
+                ScanJob job;
+                job.priority = ScanJobPriority::Discovery;
+                job.purpose = (uint8_t)ScanPurpose::AutoFull;
+                enqueueScanJob(job);
+                return true;
+            }
         }
     }
 
-    if (autoRescanKnownEnabled) {
-        long intervalMs = (autoRescanActive?autoRescanKnownIntervalSec:autoRescanWaitIntervalSec) * 1000;
+    if (rescanEnabled) {
+        // The priority scheduler decides per entry when it is due, so it only needs polling at the scan interval
+        long intervalMs = ((autoRescanActive || autoRescanPriority) ? autoRescanKnownIntervalSec : autoRescanWaitIntervalSec) * 1000;
         if (lastAutoRescanTime == 0 || (millis() - lastAutoRescanTime >= intervalMs)) {
             lastAutoRescanTime = millis();
             // If we have nothing yet, seed with a full scan.
             if (scannedNetworkList.empty()) {
                 DBG_PRINTLN_L(2,"WiFi: Auto-rescan (existing networks) has no existing list, cannot rescan.");
             } else {
-                DBG_PRINTF_L(3,"WiFi: Auto-rescan (existing networks) initiated. knownOnly=%s\n", autoRescanKnownOnlySetting ? "true" : "false");
-                scanPurpose = ScanPurpose::AutoRescanSingle;
-                startAutoRescanNext(autoRescanKnownOnlySetting);
-                return true;
+                DBG_PRINTF_L(3,"WiFi: Auto-rescan (existing networks) initiated. knownOnly=%s\n", rescanKnownOnly ? "true" : "false");
+                return startAutoRescanNext(rescanKnownOnly);
             }
         }
     }
@@ -1999,9 +4104,27 @@ bool RoamingWiFiManager::handleAutomaticScanning() {
 
 bool RoamingWiFiManager::handleAsyncScanCompletion() {
     // Handle async scan completion (used by /wifi/scan and auto-scan)
-    if (!scanInProgress || WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+    if (!scanInProgress) {
         return false;
     }
+    if (WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+        if (!scanAbortRequested || millis() - scanAbortTime < ScanAbortTimeoutMs) {
+            return false;
+        }
+        DBG_PRINTLN_L(1,"WiFi: Preempted scan did not report completion; continuing anyway.");
+    }
+
+    noteScanEnded();
+    if (scanAbortRequested) {
+        // The results of a preempted scan are incomplete: discard them and queue the job again
+        scanAbortRequested = false;
+        scanInProgress = false;
+        WiFi.scanDelete();
+        DBG_PRINTF_L(3,"WiFi: Scan (%s) preempted, queued again.\n", toString(scanPurpose).c_str());
+        scanJobs.push(runningScanJob); // keeps its place and enqueue time
+        scanPurpose = ScanPurpose::None;
+        return true;
+    }
 
     const int scanResult = WiFi.scanComplete();
     if (WiFi.isConnected()) {
@@ -2011,6 +4134,9 @@ bool RoamingWiFiManager::handleAsyncScanCompletion() {
     }
     DBG_PRINTF_L(3,"WiFi: Async scan completed. scanPurpose=%s scanResult=%d\n", toString(scanPurpose).c_str(), scanResult);
     scanInProgress = false;
+    if (autoRescanActive && isSweepPurpose(scanPurpose)) {
+        autoRescanSweepRadioMs += (uint32_t)(millis() - lastScanStartTime);
+    }
 
     if (scanResult == WIFI_SCAN_FAILED) {
         DBG_PRINTLN_L(1,"WiFi: Asynchronous scanning failed.");
@@ -2018,20 +4144,30 @@ bool RoamingWiFiManager::handleAsyncScanCompletion() {
         if (scanPurpose == ScanPurpose::AutoRescanTestChannel) {
             DBG_PRINTF_L(3,"WiFi: Auto-rescan test channel %d failed.\n", autoRescanTargetChannel);
         }
+        if (scanPurpose == ScanPurpose::FullScanChunk) {
+            DBG_PRINTF_L(3,"WiFi: Full scan chunk on channel %u failed.\n", (unsigned)runningScanJob.channel);
+            advanceChunkedFullScan(); // the channel keeps its entries as they were
+        }
+        if (scanPurpose == ScanPurpose::AutoRescanChannel) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan channel %d failed.\n", autoRescanTargetChannel);
+            if (autoRescanActive) {
+                autoRescanIndex++;
+            }
+        }
         if (scanPurpose == ScanPurpose::AutoRescanSingle) {
             if (autoRescanActive) {
                 if (autoRescanIndex < scannedNetworkList.size()) {
                     scannedNetworkList[autoRescanIndex].scanned = true;
                     scannedNetworkList[autoRescanIndex].detected = false;
+                    noteNetworkChanged(scannedNetworkList[autoRescanIndex]);
                     //scannedNetworkList[autoRescanIndex].rssi = -1000;
                     lastNetworksScanTime = millis();
                     lastNetworksScanType = "rescan";
                 }
                 autoRescanIndex++;
-                startAutoRescanNext(autoRescanKnownOnly);
             }
         } else {
-            // AutoFull, ManualFull
+            // AutoFull, ManualFull, ReconnectFull, RoamVerify
         }                
         return true;
     }
@@ -2042,18 +4178,20 @@ bool RoamingWiFiManager::handleAsyncScanCompletion() {
             DBG_PRINTLN_L(4,"WiFi: Auto-rescan: no networks found in scan.");
             WiFi.scanDelete();
             if (autoRescanActive) {
+                noteDwellOutcome(autoRescanTargetChannel, false);
                 if (autoRescanIndex < scannedNetworkList.size()) {
+                    noteDwellMiss(scannedNetworkList[autoRescanIndex]);
                     scannedNetworkList[autoRescanIndex].scanned = true;
                     scannedNetworkList[autoRescanIndex].detected = false;
+                    noteNetworkChanged(scannedNetworkList[autoRescanIndex]);
                     //scannedNetworkList[autoRescanIndex].rssi = -1000;
                     lastNetworksScanTime = millis();
                     lastNetworksScanType = "rescan";
                 }
-                // Skip this entry and continue.
+                // Skip this entry; the sweep continues from dispatchScanJobs().
                 autoRescanIndex++;
                 lastNetworksScanTime = millis();
                 lastAutoRescanTime = millis();
-                startAutoRescanNext(autoRescanKnownOnly);
             }
             return true;
         }
@@ -2061,48 +4199,55 @@ bool RoamingWiFiManager::handleAsyncScanCompletion() {
             DBG_PRINTF_L(3,"WiFi: Auto-rescan: expected to find 1 network, but found %d\n. Processing first network only.", scanResult);
         }
         // use autoRescanIndex
-        if (!WiFi.BSSIDstr(0).equalsIgnoreCase(autoRescanTargetBssid) || WiFi.channel(0) != autoRescanTargetChannel) {
-            DBG_PRINTF_L(3,"WiFi: Auto-rescan: BSSID mismatch! Found BSSID=%s channel=%d, but requested BSSID=%s channel=%d\n", WiFi.BSSIDstr(0).c_str(), WiFi.channel(0), autoRescanTargetBssid.c_str(), autoRescanTargetChannel);
+        const wifi_ap_record_t* found = getScanRecord(0);
+        const uint64_t foundBssid = found ? bssidToKey(found->bssid) : 0;
+        const int foundChannel = found ? found->primary : 0;
+        if (foundBssid != autoRescanTargetBssid || foundChannel != autoRescanTargetChannel) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan: BSSID mismatch! Found BSSID=%s channel=%d, but requested BSSID=%s channel=%d\n",
+                BssidStr(foundBssid).c_str(), foundChannel, BssidStr(autoRescanTargetBssid).c_str(), autoRescanTargetChannel);
             WiFi.scanDelete();
             // Continue scanning the next entry anyway
             lastNetworksScanTime = millis();
             lastAutoRescanTime = millis();
             lastNetworksScanType = "rescan";
+            noteDwellOutcome(autoRescanTargetChannel, false);
             if (autoRescanIndex < scannedNetworkList.size()) {
+                noteDwellMiss(scannedNetworkList[autoRescanIndex]);
                 scannedNetworkList[autoRescanIndex].scanned = true;
                 scannedNetworkList[autoRescanIndex].detected = false;
+                noteNetworkChanged(scannedNetworkList[autoRescanIndex]);
                 //scannedNetworkList[autoRescanIndex].rssi = -1000;
             }
             autoRescanIndex++;
-            startAutoRescanNext(autoRescanKnownOnly);
             return true;
         }
 
         ScannedNetwork& entry = scannedNetworkList[autoRescanIndex];
         bool entryOk = true;
-        if (entry.ssid != WiFi.SSID(0)) {
-            DBG_PRINTF_L(3,"WiFi: Auto-rescan: SSID mismatch! Found SSID=%s, but expected SSID=%s\n", WiFi.SSID(0).c_str(), entry.ssid.c_str());
+        if (strncmp(entry.ssid, (const char*)found->ssid, sizeof(entry.ssid)) != 0) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan: SSID mismatch! Found SSID=%s, but expected SSID=%s\n", (const char*)found->ssid, entry.ssid);
             entryOk = false;
         }
-        if (entry.bssid != WiFi.BSSIDstr(0)) {
-            DBG_PRINTF_L(3,"WiFi: Auto-rescan: BSSID mismatch! Found BSSID=%s, but expected BSSID=%s\n", WiFi.BSSIDstr(0).c_str(), entry.bssid.c_str());
+        if (entry.bssidKey() != foundBssid) {
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan: BSSID mismatch! Found BSSID=%s, but expected BSSID=%s\n", BssidStr(foundBssid).c_str(), entry.bssidStr().c_str());
             entryOk = false;
         }
         if (entryOk) {
-            entry.ssid = WiFi.SSID(0); // must stay same
-            entry.bssid = WiFi.BSSIDstr(0); // must stay same
-            entry.rssi = WiFi.RSSI(0); // typically updated
-            entry.channel = WiFi.channel(0); // should stay same
-            entry.encryption = (WiFi.encryptionType(0) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted"; // should stay same
-            entry.scanned = true;
-            entry.detected = true;
-            entry.known = isKnownSsid(entry.ssid);
+            noteDwellOutcome(autoRescanTargetChannel, true);
+            entry.dwellBoost = 0;
+            updateNetworkFromRecord(entry, *found);
+            if (autoRescanGroupRadios) {
+                refreshRadioMembers(entry);
+            }
 
-            DBG_PRINTF_L(3,"WiFi: Auto-rescan: updated %s index %d RSSI=%d ch=%u\n", entry.bssid.c_str(), (int)autoRescanIndex, (int)entry.rssi, (unsigned)entry.channel);
+            DBG_PRINTF_L(3,"WiFi: Auto-rescan: updated %s index %d RSSI=%d ch=%u\n", entry.bssidStr().c_str(), (int)autoRescanIndex, (int)entry.rssi, (unsigned)entry.channel);
         } else {
             DBG_PRINTF_L(3,"WiFi: Auto-rescan: index %d: entry mismatch, marking as not detected.\n", (int)autoRescanIndex);
+            noteDwellOutcome(autoRescanTargetChannel, false);
+            noteDwellMiss(entry);
             entry.scanned = true;
             entry.detected = false;
+            noteNetworkChanged(entry);
         }
         lastNetworksScanTime = millis();
         lastAutoRescanTime = millis();
@@ -2110,90 +4255,140 @@ bool RoamingWiFiManager::handleAsyncScanCompletion() {
 
         WiFi.scanDelete();
         autoRescanIndex++;
-        startAutoRescanNext(autoRescanKnownOnly);
+        // Decide on roaming now, with the fresh RSSI, before the next rescan occupies the radio.
+        // The sweep resumes from autoRescanIndex at the next rescan interval (see dispatchScanJobs()).
+        handleAutoRoaming();
+        return true;
+    }
+
+    if (scanPurpose == ScanPurpose::AutoRescanChannel) {
+        DBG_PRINTF_L(3,"WiFi: Auto-rescan channel %d: %d networks found, processing...\n", autoRescanTargetChannel, scanResult);
+        const uint32_t mergeStartMs = millis();
+        mergeChannelScanResults(scanResult);
+        WiFi.scanDelete();
+        // Entries on this channel that were eligible for the sweep but not in the result are gone
+        bool anyFound = false;
+        for (auto& net : scannedNetworkList) {
+            if (net.channel != autoRescanTargetChannel || (autoRescanKnownOnly && !net.isKnown())) {
+                continue;
+            }
+            if ((int32_t)(net.lastSeenMs - mergeStartMs) >= 0) {
+                anyFound = true;
+                net.dwellBoost = 0;
+                continue; // updated from this scan
+            }
+            noteDwellMiss(net);
+            net.scanned = true;
+            net.detected = false;
+            scheduleRescan(net);
+            noteNetworkChanged(net);
+        }
+        noteDwellOutcome(autoRescanTargetChannel, anyFound);
+        enforceApTableLimits();
+        lastNetworksScanTime = millis();
+        lastAutoRescanTime = millis();
+        lastNetworksScanType = "rescan";
+        autoRescanIndex++;
+        handleAutoRoaming();
         return true;
     }
 
     if (scanPurpose == ScanPurpose::AutoRescanTestChannel) {
+        autoRescanTestChannelDone = true;
         if (scanResult == 0) {
             DBG_PRINTF_L(3,"WiFi: Auto-rescan test channel %d: no networks found.\n", autoRescanTargetChannel);
             WiFi.scanDelete();
+            recordTestChannelYield(autoRescanTestChannelIndex, 0);
             lastNetworksScanTime = millis();
             lastAutoRescanTime = millis();
             lastNetworksScanType = "rescan";
-            // Continue with next channel
-            startAutoRescanNext(autoRescanKnownOnly);
             return true;
         }
         DBG_PRINTF_L(3,"WiFi: Auto-rescan test channel %d: %d networks found, processing...\n", autoRescanTargetChannel, scanResult);
         // Process all found networks on this channel
-        for (int i = 0; i < scanResult; i++) {
-            String bssidStr = WiFi.BSSIDstr(i);
-            // Find matching entry in scannedNetworkList
-            bool matched = false;
-            for (auto& entry : scannedNetworkList) {
-                if (entry.bssid.equalsIgnoreCase(bssidStr)) {
-                    // Update entry
-                    entry.ssid = WiFi.SSID(i); // should stay same
-                    entry.rssi = WiFi.RSSI(i); // typically updated
-                    entry.channel = WiFi.channel(i); // should stay same
-                    entry.encryption = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted"; // should stay same
-                    entry.scanned = true;
-                    entry.detected = true;
-                    entry.known = isKnownSsid(entry.ssid);
-                    DBG_PRINTF_L(3,"WiFi: Auto-rescan test channel: updated %s RSSI=%d ch=%u\n", entry.bssid.c_str(), (int)entry.rssi, (unsigned)entry.channel);
-                    matched = true;
-                    break;
-                }
-            }
-            if (!matched) {
-                DBG_PRINTF_L(3,"WiFi: Auto-rescan test channel: found unknown network %s on channel %d\n", bssidStr.c_str(), autoRescanTargetChannel);
-                ScannedNetwork newEntry;
-                newEntry.ssid = WiFi.SSID(i);
-                newEntry.bssid = WiFi.BSSIDstr(i);
-                newEntry.rssi = WiFi.RSSI(i);
-                newEntry.channel = WiFi.channel(i);
-                newEntry.encryption = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted";
-                newEntry.scanned = true;
-                newEntry.detected = true;
-                newEntry.known = isKnownSsid(WiFi.SSID(i));
-                scannedNetworkList.push_back(newEntry);
-            }
-
-        }
+        recordTestChannelYield(autoRescanTestChannelIndex, mergeChannelScanResults(scanResult));
         WiFi.scanDelete();
+        enforceApTableLimits(); // test channels keep discovering new BSSIDs
         lastNetworksScanTime = millis();
         lastAutoRescanTime = millis();
         lastNetworksScanType = "rescan";
-        // Continue with next channel
-        scanPurpose = ScanPurpose::AutoRescanSingle;
-        startAutoRescanNext(autoRescanKnownOnly);
+        handleAutoRoaming();
+        return true;
+    }
+
+    if (scanPurpose == ScanPurpose::RoamVerify) {
+        const uint32_t mergeStartMs = millis();
+        mergeChannelScanResults(scanResult);
+        WiFi.scanDelete();
+        const int pos = findNetworkIndex(runningScanJob.bssidKey);
+        if (pos >= 0 && (int32_t)(scannedNetworkList[(size_t)pos].lastSeenMs - mergeStartMs) < 0) {
+            ScannedNetwork& entry = scannedNetworkList[(size_t)pos];
+            DBG_PRINTF_L(2,"WiFi: Auto-roam: candidate %s not found when verifying.\n", entry.bssidStr().c_str());
+            entry.scanned = true;
+            entry.detected = false;
+            scheduleRescan(entry);
+            noteNetworkChanged(entry);
+        }
+        enforceApTableLimits();
+        lastNetworksScanTime = millis();
+        scanPurpose = ScanPurpose::None;
+        handleAutoRoaming(); // decide again with the verified RSSI
+        return true;
+    }
+
+    if (scanPurpose == ScanPurpose::FullScanChunk) {
+        // Like a full scan, every entry on this channel that was not heard is no longer detected.
+        // A directed step only looked for its own SSID; earlier steps on the channel count as heard.
+        const uint8_t channel = runningScanJob.channel;
+        const int directedCredential = (runningScanJob.ssidIndex != ScanJob::NoSsid) ? (int)runningScanJob.ssidIndex : -1;
+        mergeChannelScanResults(scanResult);
+        WiFi.scanDelete();
+        fullScanChunkRecords += (uint32_t)scanResult;
+        for (auto& entry : scannedNetworkList) {
+            if (entry.channel == channel && entry.detected && (int32_t)(entry.lastSeenMs - fullScanChunkChannelStartMs) < 0 &&
+                (directedCredential < 0 || entry.credentialIndex() == directedCredential)) {
+                entry.scanned = true;
+                entry.detected = false;
+                noteNetworkChanged(entry);
+            }
+        }
+        DBG_PRINTF_L(4,"WiFi: Full scan chunk on channel %u%s%s: %d networks\n", (unsigned)channel,
+            directedCredential >= 0 ? " for " : "", directedCredential >= 0 ? knownNetworks[(size_t)directedCredential].ssid.c_str() : "", scanResult);
+        scanPurpose = ScanPurpose::None;
+        if (fullScanChunkNext + 1 < autoRescanTestChannelList.size() || fullScanChunkStep + 1 < fullScanChunkSteps) {
+            enforceApTableLimits();
+            publishFullScanChunk();
+        }
+        advanceChunkedFullScan();
         return true;
     }
 
-    if (scanPurpose == ScanPurpose::AutoFull || scanPurpose == ScanPurpose::ManualFull) {
+    if (scanPurpose == ScanPurpose::AutoFull || scanPurpose == ScanPurpose::ManualFull || scanPurpose == ScanPurpose::ReconnectFull) {
         // Full scan case
         DBG_PRINTLN_L(2,"WiFi: Full scanning completed, processing results...");
         copyScannedNetworksToList(true);
-        printNetworks();
-        lastNetworksScanTime = millis();
-        lastAutoFullScanTime = millis();
-        lastNetworksScanType = "full";
-        networkScanCount++;
-        scanPurpose = ScanPurpose::None;
+        finishFullScan(scanPurpose);
         return true;
     }
 
+    WiFi.scanDelete(); // results nobody waits for anymore, e.g. of a sweep reset by a settings change
     return false;
 }
 
 void RoamingWiFiManager::loop() {
+    syncConnectionSnapshot();
     if (WiFi.status() == WL_CONNECTED) {
         // Reset auto-reconnect counters when connected
         lastAutoReconnectAttemptTime = 0;
         autoReconnectAttemptCount = 0;
     }
 
+    // Fresh RSSI of the serving AP and of same-channel APs, without a scan
+    handleConnectedRssiSampling();
+    handleBeaconHarvest();
+    handleConnectFailures();
+    handleAirtimeBudget();
+
     // When connected, optionally roam to a stronger network if enabled
     handleAutoRoaming();
     if (WiFi.status() == WL_CONNECTED) {
@@ -2218,8 +4413,12 @@ void RoamingWiFiManager::loop() {
         return;
     }
 
-    // Start automatic scanning if enabled and time elapsed
-    if (handleAutomaticScanning()) {
+    // Queue scans requested through the web interface, then automatic scans (full or rescan) if enabled and time elapsed
+    handleScanRequests();
+    handleAutomaticScanning();
+
+    // Start the most urgent queued scan, or preempt a running low-priority one
+    if (dispatchScanJobs()) {
         return;
     }
 
@@ -2228,7 +4427,13 @@ void RoamingWiFiManager::loop() {
 }
 
 bool RoamingWiFiManager::useLEDIndicator = true;
+RoamingWiFiManager* RoamingWiFiManager::promiscuousOwner = nullptr;
 
 void RoamingWiFiManager::setUseLEDIndicator(bool enable) {
     useLEDIndicator = enable;
 }
+
+void RoamingWiFiManager::setScoreFunction(ApScoreFunction fn) {
+    customScoreFunction = fn;
+    roamCandidates.markAllDirty();
+}
@@ -0,0 +1,92 @@
+// Merging one scan result into the AP table: the packed-key BssidIndex against the linear search the
+// table used before, which compared BSSID strings with String::equalsIgnoreCase().
+#include "BssidIndex.h"
+#include "host_test.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+// BSSIDs as a campus mesh shows them: a handful of vendor OUIs, random device parts.
+static std::vector<uint64_t> makeBssids(size_t n, std::mt19937& rng) {
+    static const uint64_t ouis[4] = {0x709041, 0x00F663, 0xB4E9B8, 0x3C5731};
+    std::vector<uint64_t> keys;
+    while (keys.size() < n) {
+        const uint64_t key = (ouis[rng() % 4] << 24) | (rng() & 0xFFFFFF);
+        if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+static std::string bssidString(uint64_t key) {
+    char s[18];
+    bssidKeyToChars(key, s);
+    return s;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    printf("%6s %16s %16s %9s\n", "APs", "linear (us)", "indexed (us)", "speedup");
+    for (const size_t n : {(size_t)50, (size_t)500, (size_t)2000}) {
+        const std::vector<uint64_t> table = makeBssids(n, rng);
+        std::vector<uint64_t> scan = table; // every record is already in the table: the common case
+        std::shuffle(scan.begin(), scan.end(), rng);
+
+        // Before: the table held BSSID strings, and each record's string (WiFi.BSSIDstr(i)) was compared
+        // case-insensitively against every entry until a match.
+        std::vector<std::string> tableStrings;
+        for (const uint64_t key : table) {
+            tableStrings.push_back(bssidString(key));
+        }
+        long linearSum = 0;
+        const double linearNs = hosttest::nsPerCall([&] {
+            for (const uint64_t key : scan) {
+                const std::string record = bssidString(key);
+                for (size_t j = 0; j < tableStrings.size(); j++) {
+                    if (strcasecmp(tableStrings[j].c_str(), record.c_str()) == 0) {
+                        linearSum += (long)j;
+                        break;
+                    }
+                }
+            }
+        });
+
+        // Now: the record's 6 bytes are packed and looked up in the hash index.
+        BssidIndex index;
+        index.reserve(n);
+        for (size_t i = 0; i < table.size(); i++) {
+            index.insert(table[i], (int32_t)i);
+        }
+        std::vector<uint8_t> records(scan.size() * 6);
+        for (size_t i = 0; i < scan.size(); i++) {
+            bssidFromKey(scan[i], &records[i * 6]);
+        }
+        long indexedSum = 0;
+        const double indexedNs = hosttest::nsPerCall([&] {
+            for (size_t i = 0; i < scan.size(); i++) {
+                indexedSum += index.find(bssidToKey(&records[i * 6]));
+            }
+        });
+        hosttest::keep(linearSum);
+        hosttest::keep(indexedSum);
+
+        // Both must find the same positions
+        long expected = 0;
+        for (const uint64_t key : scan) {
+            const int32_t pos = index.find(key);
+            CHECK(pos >= 0 && table[(size_t)pos] == key);
+            expected += pos;
+        }
+        CHECK(index.find(0x123456789ABCULL) == BssidIndex::NotFound);
+        CHECK(expected == (long)(n * (n - 1) / 2));
+
+        printf("%6zu %16.1f %16.2f %8.0fx\n", n, linearNs / 1000.0, indexedNs / 1000.0, linearNs / indexedNs);
+        if (n >= 500) {
+            CHECK(indexedNs < linearNs); // the index must win once the table is more than tiny
+        }
+    }
+    return hosttest::finish();
+}
@@ -0,0 +1,33 @@
+// Parse cost per heard frame: BeaconParser on the sample beacon (about 300 bytes, the size of a
+// typical enterprise AP beacon), and InfoElements::parse on its element list alone.
+#include "BeaconParser.h"
+#include "InfoElements.h"
+#include "host_test.h"
+#include "sample_frames.h"
+
+int main() {
+    static constexpr size_t IesOffset = BeaconParser::HeaderLen + BeaconParser::FixedFieldsLen;
+    BeaconInfo info;
+    CHECK(BeaconParser::parse(beaconFrame, sizeof(beaconFrame), info));
+    CHECK(sizeof(beaconFrame) >= 280 && sizeof(beaconFrame) <= 320);
+
+    const double frameNs = hosttest::nsPerCall([&] {
+        hosttest::keep(BeaconParser::parse(beaconFrame, sizeof(beaconFrame), info));
+        hosttest::keep(info);
+    }, 200.0);
+    ApCapabilities caps;
+    const double iesNs = hosttest::nsPerCall([&] {
+        hosttest::keep(InfoElements::parse(beaconFrame + IesOffset, sizeof(beaconFrame) - IesOffset, caps));
+        hosttest::keep(caps);
+    }, 200.0);
+    CHECK(caps.akms == (ApCapabilities::AkmPsk | ApCapabilities::AkmSae));
+
+    size_t elements = 0;
+    InfoElements::forEach(beaconFrame + IesOffset, sizeof(beaconFrame) - IesOffset,
+                          [&elements](uint8_t, const uint8_t*, uint8_t) { elements++; });
+    printf("beacon of %zu bytes, %zu elements:\n", sizeof(beaconFrame), elements);
+    printf("  BeaconParser::parse    %7.1f ns/frame\n", frameNs);
+    printf("  InfoElements::parse    %7.1f ns/element list\n", iesNs);
+    CHECK(frameNs < 10000.0); // gross regressions only; the host is far faster than the target
+    return hosttest::finish();
+}
@@ -0,0 +1,61 @@
+// RssiFilter: cost of one update() (called for every scan, beacon and connected-AP sample), and how
+// it tracks a walk away from an AP through 4 dB of sample noise.
+#include "RssiFilter.h"
+#include "host_test.h"
+#include <math.h>
+#include <random>
+#include <vector>
+
+int main() {
+    static_assert(sizeof(RssiFilter) == 6, "RssiFilter is part of every AP table entry");
+
+    // Noisy samples of a level falling 0.5 dB/s, one every 250 ms (connected-AP sampling)
+    std::mt19937 rng(25);
+    std::normal_distribution<float> noise(0.0f, 4.0f);
+    const uint32_t dtMs = 250;
+    std::vector<int8_t> samples(400); // 100 s, -50 to -100 dBm
+    for (size_t i = 0; i < samples.size(); i++) {
+        const float level = -50.0f - 0.5f * (float)(i * dtMs) / 1000.0f;
+        samples[i] = (int8_t)lroundf(level + noise(rng));
+    }
+
+    RssiFilter filter;
+    CHECK(filter.empty());
+    filter.update(samples[0], 0);
+    CHECK(!filter.empty() && filter.rssi() == samples[0]);
+    float sumSquaredError = 0.0f;
+    float sumSquaredNoise = 0.0f;
+    float sumSlope = 0.0f;
+    for (size_t i = 1; i < samples.size(); i++) {
+        filter.update(samples[i], dtMs);
+        const float level = -50.0f - 0.5f * (float)(i * dtMs) / 1000.0f;
+        if (i >= 80) { // after settling
+            sumSquaredError += (filter.level() - level) * (filter.level() - level);
+            sumSquaredNoise += ((float)samples[i] - level) * ((float)samples[i] - level);
+            sumSlope += filter.slopeDbPerSec();
+        }
+    }
+    const float rmsError = sqrtf(sumSquaredError / (float)(samples.size() - 80));
+    const float rmsNoise = sqrtf(sumSquaredNoise / (float)(samples.size() - 80));
+    const float meanSlope = sumSlope / (float)(samples.size() - 80);
+    printf("0.5 dB/s ramp, 4 dB noise: mean slope %.2f dB/s, std dev %.1f dB, level error %.2f dB rms (samples %.2f dB rms)\n",
+           meanSlope, filter.stdDevDb(), rmsError, rmsNoise);
+    CHECK(fabsf(meanSlope + 0.5f) < 0.2f);
+    CHECK(fabsf(filter.stdDevDb() - 4.0f) < 1.5f);
+    CHECK(rmsError < 0.75f * rmsNoise);
+
+    // A gap longer than RestartGapMs drops the track
+    filter.update(-70, RssiFilter::RestartGapMs + 1);
+    CHECK(filter.rssi() == -70 && filter.slopeDbPerSec() == 0.0f);
+
+    // Per-update cost, over the recorded samples
+    size_t next = 0;
+    const double ns = hosttest::nsPerCall([&] {
+        filter.update(samples[next], dtMs);
+        next = next + 1 == samples.size() ? 0 : next + 1;
+        hosttest::keep(filter);
+    }, 200.0);
+    printf("update(): %.1f ns\n", ns);
+    CHECK(ns < 1000.0);
+    return hosttest::finish();
+}
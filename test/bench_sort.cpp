@@ -0,0 +1,89 @@
+// Re-sorting a 500-entry AP table as sortNetworks() does: after a few RSSI updates (insertion path),
+// and from a shuffled order (std::sort path). Both must stay well below 1 ms on the host.
+#include "NearlySorted.h"
+#include "host_test.h"
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+// Same size and sort key as ScannedNetwork (group rank, RSSI descending, BSSID).
+struct Entry {
+    char ssid[33];
+    uint8_t rank;
+    int8_t rssi;
+    uint8_t pad[25];
+    uint64_t bssidKey;
+};
+
+static bool sortsBefore(const Entry& a, const Entry& b) {
+    if (a.rank != b.rank) {
+        return a.rank < b.rank;
+    }
+    if (a.rssi != b.rssi) {
+        return a.rssi > b.rssi;
+    }
+    return a.bssidKey < b.bssidKey;
+}
+
+static constexpr size_t Entries = 500;
+static constexpr size_t MaxDirty = 16; // RoamingWiFiManager::SortInsertionMaxDirty
+
+// Times copying src and sorting the copy; returns us per sort (the copy included).
+static double usPerSort(const std::vector<Entry>& src, std::vector<Entry>& out) {
+    return hosttest::nsPerCall([&] {
+        out = src;
+        sortNearlySorted(out, sortsBefore, countOutOfOrder(out, sortsBefore), MaxDirty);
+        hosttest::keep(out[0]);
+    }) / 1000.0;
+}
+
+static bool sameOrder(std::vector<Entry> sorted, const std::vector<Entry>& src) {
+    std::vector<Entry> expected = src;
+    std::sort(expected.begin(), expected.end(), sortsBefore);
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (expected[i].bssidKey != sorted[i].bssidKey) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(4);
+    std::vector<Entry> table(Entries);
+    for (size_t i = 0; i < Entries; i++) {
+        table[i] = Entry{};
+        table[i].rank = (uint8_t)(i < 20 ? 0 : (i < 40 ? 2 : 3));
+        table[i].rssi = (int8_t)(-40 - (int)(rng() % 55));
+        table[i].bssidKey = 0x709041000000ULL + i;
+    }
+    std::sort(table.begin(), table.end(), sortsBefore);
+    std::vector<Entry> out;
+
+    const double sortedUs = usPerSort(table, out);
+    CHECK(sameOrder(out, table));
+
+    std::vector<Entry> nearly = table; // a rescan sweep refreshed a few RSSIs
+    for (int i = 0; i < 6; i++) {
+        nearly[rng() % Entries].rssi = (int8_t)(-40 - (int)(rng() % 55));
+    }
+    const size_t dirty = countOutOfOrder(nearly, sortsBefore);
+    CHECK(dirty <= MaxDirty);
+    const double nearlyUs = usPerSort(nearly, out);
+    CHECK(sameOrder(out, nearly));
+
+    std::vector<Entry> shuffled = table; // e.g. the SSID connected to changed the ranks
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    CHECK(countOutOfOrder(shuffled, sortsBefore) > MaxDirty);
+    const double shuffledUs = usPerSort(shuffled, out);
+    CHECK(sameOrder(out, shuffled));
+
+    printf("%zu entries of %zu bytes, copy + sort:\n", Entries, sizeof(Entry));
+    printf("  sorted                    %8.2f us\n", sortedUs);
+    printf("  nearly sorted (%2zu dirty)  %8.2f us\n", dirty, nearlyUs);
+    printf("  shuffled                  %8.2f us\n", shuffledUs);
+    CHECK(sortedUs < 1000.0);
+    CHECK(nearlyUs < 1000.0);
+    CHECK(shuffledUs < 1000.0);
+    return hosttest::finish();
+}
@@ -0,0 +1,173 @@
+// Random and mutated element lists through InfoElements and BeaconParser. Every buffer is a heap block
+// of exactly its length, so under AddressSanitizer any read past the end fails the test.
+// Usage: fuzz_info_elements [iterations] [seed]
+#include "BeaconParser.h"
+#include "InfoElements.h"
+#include "host_test.h"
+#include "sample_frames.h"
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr size_t IesOffset = BeaconParser::HeaderLen + BeaconParser::FixedFieldsLen;
+
+// Parses len bytes from a copy in an exactly sized heap block and checks the walk's invariants.
+static void parseExact(const uint8_t* data, size_t len) {
+    uint8_t* buf = new uint8_t[len ? len : 1];
+    memcpy(buf, data, len);
+
+    size_t visited = 0;
+    size_t covered = 0;
+    bool inBounds = true;
+    const bool complete = InfoElements::forEach(buf, len, [&](uint8_t, const uint8_t* body, uint8_t bodyLen) {
+        inBounds = inBounds && body >= buf + 2 && body + bodyLen <= buf + len;
+        visited++;
+        covered += 2 + (size_t)bodyLen;
+    });
+    CHECK(inBounds);
+    CHECK(visited <= InfoElements::MaxElements);
+    CHECK(covered <= len);
+    if (complete) {
+        CHECK(covered == len); // a complete walk accounts for every byte
+    }
+    ApCapabilities caps;
+    CHECK(InfoElements::parse(buf, len, caps) == complete);
+    CHECK(caps.widthMhz20 == 0 || caps.widthMhz20 == 1 || caps.widthMhz20 == 2 || caps.widthMhz20 == 4 || caps.widthMhz20 == 8);
+    CHECK((caps.flags & ApCapabilities::FlagFromBeacon) != 0);
+    delete[] buf;
+}
+
+static void parseFrameExact(const uint8_t* data, size_t len) {
+    uint8_t* buf = new uint8_t[len ? len : 1];
+    memcpy(buf, data, len);
+    BeaconInfo info;
+    if (BeaconParser::parse(buf, len, info)) {
+        CHECK(strlen(info.ssid) <= 32);
+    }
+    delete[] buf;
+}
+
+// The RSN element (header included) of the sample beacon.
+static const uint8_t* beaconRsnElement() {
+    const uint8_t* rsn = nullptr;
+    InfoElements::forEach(beaconFrame + IesOffset, sizeof(beaconFrame) - IesOffset,
+        [&rsn](uint8_t id, const uint8_t* body, uint8_t) {
+            if (id == InfoElements::IeRsn) {
+                rsn = body - 2;
+            }
+        });
+    return rsn;
+}
+
+// RSN bodies whose suite counts claim more suites than the element holds (count * 4 past the end).
+static void testRsnCounts() {
+    ApCapabilities caps;
+    static const uint16_t counts[] = {0, 1, 2, 3, 0x3FFF, 0x4000, 0x4001, 0x7FFF, 0xFFFF};
+    for (const uint16_t count : counts) {
+        // Pairwise count with a single CCMP suite present
+        std::vector<uint8_t> rsn = {0x30, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, (uint8_t)count, (uint8_t)(count >> 8),
+                                    0x00, 0x0f, 0xac, 0x04};
+        rsn[1] = (uint8_t)(rsn.size() - 2);
+        parseExact(rsn.data(), rsn.size());
+        InfoElements::parse(rsn.data(), rsn.size(), caps);
+        CHECK(caps.ciphers == (count == 1 ? ApCapabilities::CipherCcmp : 0));
+
+        // AKM count with a single PSK suite present, after a valid pairwise list
+        rsn = {0x30, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,
+               (uint8_t)count, (uint8_t)(count >> 8), 0x00, 0x0f, 0xac, 0x02};
+        rsn[1] = (uint8_t)(rsn.size() - 2);
+        parseExact(rsn.data(), rsn.size());
+        InfoElements::parse(rsn.data(), rsn.size(), caps);
+        CHECK(caps.ciphers == ApCapabilities::CipherCcmp);
+        CHECK(caps.akms == (count == 1 ? ApCapabilities::AkmPsk : 0));
+        CHECK((caps.flags & (ApCapabilities::FlagPmfCapable | ApCapabilities::FlagPmfRequired)) == 0);
+    }
+    // Lists that end exactly at the element end, RSN capabilities cut in half
+    std::vector<uint8_t> rsn = {0x30, 0x0f, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,
+                                0x00, 0x00, 0xc0};
+    parseExact(rsn.data(), rsn.size());
+    InfoElements::parse(rsn.data(), rsn.size(), caps);
+    CHECK(caps.ciphers == ApCapabilities::CipherCcmp && caps.akms == 0);
+    CHECK((caps.flags & ApCapabilities::FlagPmfRequired) == 0);
+    // Every length of a full RSN element
+    const uint8_t* full = beaconRsnElement();
+    CHECK(full != nullptr && full[1] == 0x18);
+    for (size_t len = 0; len <= full[1]; len++) {
+        std::vector<uint8_t> cut(full, full + 2 + len);
+        cut[1] = (uint8_t)len;
+        parseExact(cut.data(), cut.size());
+    }
+}
+
+static void testMaxElements() {
+    ApCapabilities caps;
+    std::vector<uint8_t> ies(InfoElements::MaxElements * 2, 0xdd); // zero-length vendor elements
+    for (size_t i = 1; i < ies.size(); i += 2) {
+        ies[i] = 0;
+    }
+    CHECK(InfoElements::parse(ies.data(), ies.size(), caps));
+    parseExact(ies.data(), ies.size());
+    ies.push_back(0xdd);
+    ies.push_back(0x00);
+    CHECK(!InfoElements::parse(ies.data(), ies.size(), caps));
+    parseExact(ies.data(), ies.size());
+    size_t visited = 0;
+    InfoElements::forEach(ies.data(), ies.size(), [&visited](uint8_t, const uint8_t*, uint8_t) { visited++; });
+    CHECK(visited == InfoElements::MaxElements);
+}
+
+int main(int argc, char** argv) {
+    const long iterations = argc > 1 ? atol(argv[1]) : 100000;
+    std::mt19937 rng(argc > 2 ? (uint32_t)atol(argv[2]) : 23u);
+
+    testRsnCounts();
+    testMaxElements();
+
+    const std::vector<uint8_t> beacon(beaconFrame, beaconFrame + sizeof(beaconFrame));
+    const std::vector<uint8_t> beaconIes(beacon.begin() + IesOffset, beacon.end());
+    std::vector<uint8_t> buf;
+    for (long it = 0; it < iterations; it++) {
+        switch (rng() % 4) {
+            case 0: { // random bytes
+                buf.resize(rng() % 400);
+                for (uint8_t& b : buf) {
+                    b = (uint8_t)rng();
+                }
+                break;
+            }
+            case 1: { // random elements with plausible ids and short bodies
+                buf.clear();
+                const size_t elements = rng() % 80;
+                static const uint8_t ids[] = {0, 3, 11, 45, 48, 61, 191, 192, 255, 221};
+                for (size_t e = 0; e < elements; e++) {
+                    const uint8_t bodyLen = (uint8_t)(rng() % 24);
+                    buf.push_back(ids[rng() % sizeof(ids)]);
+                    buf.push_back(bodyLen);
+                    for (uint8_t b = 0; b < bodyLen; b++) {
+                        buf.push_back(rng() % 3 == 0 ? 0xff : (uint8_t)rng());
+                    }
+                }
+                break;
+            }
+            default: { // the sample beacon's elements with a few bytes changed, then maybe truncated
+                buf = beaconIes;
+                const int mutations = 1 + (int)(rng() % 4);
+                for (int m = 0; m < mutations; m++) {
+                    buf[rng() % buf.size()] = (uint8_t)rng();
+                }
+                if (rng() % 2) {
+                    buf.resize(rng() % (buf.size() + 1));
+                }
+                break;
+            }
+        }
+        parseExact(buf.data(), buf.size());
+        std::vector<uint8_t> frame(beacon.begin(), beacon.begin() + IesOffset);
+        frame.insert(frame.end(), buf.begin(), buf.end());
+        parseFrameExact(frame.data(), frame.size());
+        parseFrameExact(frame.data(), rng() % (frame.size() + 1));
+    }
+    printf("%ld iterations\n", iterations);
+    return hosttest::finish();
+}
@@ -0,0 +1,52 @@
+#pragma once
+// Minimal helpers shared by the host tests and benchmarks, so they need no test framework.
+#include <chrono>
+#include <stdio.h>
+
+namespace hosttest {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+// Exit code of main(): 0 if every CHECK passed.
+inline int finish() {
+    if (failures() != 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures());
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
+
+// Keeps a result alive, so the optimiser can't drop the work being timed.
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Calls fn repeatedly for at least minMs and returns the mean time per call in ns.
+template <typename Fn>
+double nsPerCall(Fn&& fn, double minMs = 50.0) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    size_t calls = 0;
+    double elapsedNs = 0.0;
+    do {
+        fn();
+        calls++;
+        elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    } while (elapsedNs < minMs * 1e6);
+    return elapsedNs / (double)calls;
+}
+
+} // namespace hosttest
+
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+            hosttest::failures()++;                                                      \
+        }                                                                                \
+    } while (0)
@@ -0,0 +1,73 @@
+#pragma once
+// 802.11 frames as the promiscuous callback hands them over (MAC header onwards, FCS stripped),
+// shared by the parser tests and benchmarks.
+#include <stdint.h>
+
+// Beacon of a 5 GHz enterprise AP: channel 36, 80 MHz, 802.11ax, WPA2/WPA3 personal transition mode.
+static const uint8_t beaconFrame[] = {
+    0x80, 0x00, 0x00, 0x00,                         // frame control: management, beacon; duration
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,             // address 1: broadcast
+    0x70, 0x90, 0x41, 0x12, 0x8d, 0x51,             // address 2: transmitter
+    0x70, 0x90, 0x41, 0x12, 0x8d, 0x51,             // address 3: BSSID
+    0x40, 0xa3,                                     // sequence control
+    0x1f, 0x3c, 0x8a, 0x5e, 0x0b, 0x00, 0x00, 0x00, // timestamp
+    0x64, 0x00,                                     // beacon interval: 100 TU
+    0x11, 0x15,                                     // capability information
+    0x00, 0x07, 'i', 'o', 't', 'r', 'o', 'a', 'm',  // SSID
+    0x01, 0x08, 0x8c, 0x12, 0x98, 0x24, 0xb0, 0x48, 0x60, 0x6c, // supported rates
+    0x03, 0x01, 0x24,                               // DS parameter set: channel 36
+    0x05, 0x04, 0x00, 0x01, 0x00, 0x00,             // TIM
+    0x07, 0x0a, 'N', 'L', ' ', 0x24, 0x04, 0x17, 0x64, 0x0c, 0x1e, 0x00, // country
+    0x0b, 0x05, 0x0c, 0x00, 0x8f, 0x12, 0x7a,       // BSS load: 12 stations, utilisation 143/255
+    0x20, 0x01, 0x00,                               // power constraint
+    0x2d, 0x1a, 0xef, 0x09, 0x1b,                   // HT capabilities
+    0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x30, 0x18, 0x01, 0x00,                         // RSN: version 1
+    0x00, 0x0f, 0xac, 0x04,                         //   group cipher CCMP
+    0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,             //   pairwise: CCMP
+    0x02, 0x00, 0x00, 0x0f, 0xac, 0x02, 0x00, 0x0f, 0xac, 0x08, // AKMs: PSK, SAE
+    0x80, 0x00,                                     //   RSN capabilities: MFP capable
+    0x3d, 0x16, 0x24, 0x05, 0x00, 0x00, 0x00, 0x00, // HT operation: secondary channel above, any width
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xbf, 0x0c, 0x91, 0x59, 0x82, 0x0f, 0xea, 0xff, 0x00, 0x00, 0xea, 0xff, 0x00, 0x00, // VHT capabilities
+    0xc0, 0x05, 0x01, 0x2a, 0x00, 0xfc, 0xff,       // VHT operation: 80 MHz around channel 42
+    0xff, 0x16, 0x23,                               // HE capabilities
+    0x05, 0x00, 0x08, 0x12, 0x00, 0x10, 0x22, 0x20, 0x02, 0xc0, 0x0f, 0x03, 0x95, 0x18, 0x00, 0xcc,
+    0x00, 0xfa, 0xff, 0xfa, 0xff,
+    0xff, 0x07, 0x24, 0xf4, 0x3f, 0x00, 0x25, 0xfc, 0xff, // HE operation
+    0x46, 0x05, 0x72, 0x00, 0x00, 0x00, 0x00,       // RM enabled capabilities
+    0x7f, 0x0a, 0x04, 0x00, 0x0a, 0x02, 0x01, 0x40, 0x40, 0x00, 0x00, 0x20, // extended capabilities
+    0xdd, 0x1e, 0x00, 0x0b, 0x86, 0x01, 0x03, 0x00, // vendor: AP name
+    'A', 'P', '-', 'W', 'B', '0', '4', '1', '2', '-', '3', '.', '1', '4', '-', 'N', 'L', '-', 'D', 'E', 'L', 'F', 'T', '.',
+    0xdd, 0x06, 0x00, 0x17, 0xf2, 0x0a, 0x00, 0x01, // vendor
+    0xdd, 0x18, 0x00, 0x50, 0xf2, 0x02, 0x01, 0x01, 0x80, 0x00, // WMM parameters
+    0x03, 0xa4, 0x00, 0x00, 0x27, 0xa4, 0x00, 0x00, 0x42, 0x43, 0x5e, 0x00, 0x62, 0x32, 0x2f, 0x00,
+};
+
+// Probe response of a 2.4 GHz 802.11n AP: channel 6, 20 MHz, WPA2 enterprise with fast transition.
+static const uint8_t probeResponseFrame[] = {
+    0x50, 0x00, 0x3a, 0x01,                         // frame control: management, probe response; duration
+    0xa0, 0xb7, 0x65, 0x4c, 0x11, 0x02,             // address 1: the probing station
+    0x00, 0xf6, 0x63, 0xaa, 0xbb, 0xc0,             // address 2
+    0x00, 0xf6, 0x63, 0xaa, 0xbb, 0xc0,             // address 3: BSSID
+    0x10, 0x7e,
+    0x9a, 0x42, 0x07, 0x3c, 0x51, 0x00, 0x00, 0x00, // timestamp
+    0x64, 0x00,                                     // beacon interval: 100 TU
+    0x31, 0x04,                                     // capability information
+    0x00, 0x07, 'e', 'd', 'u', 'r', 'o', 'a', 'm',  // SSID
+    0x01, 0x08, 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24, // supported rates
+    0x03, 0x01, 0x06,                               // DS parameter set: channel 6
+    0x2a, 0x01, 0x04,                               // ERP
+    0x32, 0x04, 0x30, 0x48, 0x60, 0x6c,             // extended supported rates
+    0x30, 0x18, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04, // RSN: CCMP group
+    0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,             //   pairwise: CCMP
+    0x02, 0x00, 0x00, 0x0f, 0xac, 0x01, 0x00, 0x0f, 0xac, 0x03, // AKMs: 802.1X, FT over 802.1X
+    0x28, 0x00,                                     //   RSN capabilities: no MFP
+    0x36, 0x03, 0x4a, 0x1b, 0x01,                   // mobility domain
+    0x2d, 0x1a, 0xad, 0x01, 0x1b,                   // HT capabilities
+    0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x3d, 0x16, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, // HT operation: 20 MHz
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
@@ -0,0 +1,39 @@
+// AirtimeBudget: the reporting getters match what charge() later rolls, without changing the budget.
+#include "AirtimeBudget.h"
+#include "host_test.h"
+#include <string.h>
+
+static bool sameBudget(const AirtimeBudget& a, const AirtimeBudget& b) {
+    return memcmp(&a, &b, sizeof(AirtimeBudget)) == 0;
+}
+
+int main() {
+    AirtimeBudget budget;
+    budget.configure(10.0f, 1000); // 100 ms per 1000 ms
+    CHECK(budget.allows(1000, 80));
+    budget.charge(1100, 80);
+    budget.charge(1500, 40);
+
+    // Reading in the next window reports the window just finished, and leaves the budget as it was
+    const AirtimeBudget before = budget;
+    const AirtimeBudget::Stats stats = budget.stats(2300);
+    CHECK(sameBudget(before, budget));
+    CHECK(stats.lastWindowPercent == 12.0f);
+    CHECK(stats.maxWindowPercent == 12.0f);
+    CHECK(stats.offChannelTotalMs == 120);
+    CHECK(stats.tokensMs == 100.0f); // refilled to capacity by then
+    CHECK(budget.tokensMs(1500) == 20.0f); // right after the second scan
+
+    // The scheduler's window state is untouched: charging in that window still rolls it as before
+    budget.charge(2300, 10);
+    CHECK(budget.lastWindowPercent(2300) == 12.0f);
+    CHECK(budget.stats(2300).offChannelTotalMs == 130);
+
+    // A window without scans reads as empty, two windows later
+    CHECK(budget.lastWindowPercent(4100) == 0.0f);
+    CHECK(budget.maxWindowPercent(4100) == 12.0f);
+
+    budget.noteDeferred();
+    CHECK(budget.stats(4100).deferred == 1);
+    return hosttest::finish();
+}
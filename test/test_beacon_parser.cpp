@@ -0,0 +1,258 @@
+// BeaconParser on the beacon and probe response frames of sample_frames.h and variants of them, and
+// the BeaconHarvester ring between the promiscuous callback and the loop.
+#include "BeaconHarvester.h"
+#include "BeaconParser.h"
+#include "host_test.h"
+#include "sample_frames.h"
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static constexpr size_t SsidOffset = BeaconParser::HeaderLen + BeaconParser::FixedFieldsLen;
+
+// beaconFrame with its 7-byte SSID element body replaced by ssid (ssidLen bytes).
+static std::vector<uint8_t> beaconWithSsid(const uint8_t* ssid, size_t ssidLen) {
+    std::vector<uint8_t> frame(beaconFrame, beaconFrame + SsidOffset);
+    frame.push_back(0x00);
+    frame.push_back((uint8_t)ssidLen);
+    frame.insert(frame.end(), ssid, ssid + ssidLen);
+    frame.insert(frame.end(), beaconFrame + SsidOffset + 2 + 7, beaconFrame + sizeof(beaconFrame));
+    return frame;
+}
+
+static void testBeacon() {
+    BeaconInfo info;
+    CHECK(BeaconParser::parse(beaconFrame, sizeof(beaconFrame), info));
+    static const uint8_t bssid[6] = {0x70, 0x90, 0x41, 0x12, 0x8d, 0x51};
+    CHECK(memcmp(info.bssid, bssid, 6) == 0);
+    CHECK(strcmp(info.ssid, "iotroam") == 0);
+    CHECK(info.channel == 36);
+    CHECK(info.beaconIntervalTu == 100);
+    CHECK(!info.probeResponse);
+    CHECK(info.caps.phy == (ApCapabilities::PhyHt | ApCapabilities::PhyVht | ApCapabilities::PhyHe));
+    CHECK(info.caps.widthMhz() == 80);
+    CHECK(info.caps.akms == (ApCapabilities::AkmPsk | ApCapabilities::AkmSae));
+    CHECK(info.caps.ciphers == ApCapabilities::CipherCcmp);
+    CHECK(info.caps.flags == (ApCapabilities::FlagFromBeacon | ApCapabilities::FlagBssLoad | ApCapabilities::FlagPmfCapable));
+    CHECK(info.caps.bssLoadStations == 12);
+    CHECK(info.caps.bssLoadUtil == 143);
+    char akms[24];
+    CHECK(strcmp(info.caps.akmNames(akms, sizeof(akms)), "PSK/SAE") == 0);
+    CHECK(strcmp(info.caps.phyName(), "ax") == 0);
+}
+
+static void testProbeResponse() {
+    BeaconInfo info;
+    CHECK(BeaconParser::parse(probeResponseFrame, sizeof(probeResponseFrame), info));
+    static const uint8_t bssid[6] = {0x00, 0xf6, 0x63, 0xaa, 0xbb, 0xc0};
+    CHECK(memcmp(info.bssid, bssid, 6) == 0); // address 3, not the receiver
+    CHECK(strcmp(info.ssid, "eduroam") == 0);
+    CHECK(info.channel == 6);
+    CHECK(info.probeResponse);
+    CHECK(info.caps.phy == ApCapabilities::PhyHt);
+    CHECK(info.caps.widthMhz() == 20);
+    CHECK(info.caps.akms == (ApCapabilities::AkmEap | ApCapabilities::AkmFt));
+    CHECK(info.caps.flags == ApCapabilities::FlagFromBeacon); // no BSS Load, no MFP
+}
+
+static void testHiddenSsid() {
+    BeaconInfo info;
+    // Zero-length SSID element
+    std::vector<uint8_t> frame = beaconWithSsid(nullptr, 0);
+    memset(info.ssid, 'x', sizeof(info.ssid));
+    CHECK(BeaconParser::parse(frame.data(), frame.size(), info));
+    CHECK(info.ssid[0] == '\0');
+    CHECK(info.channel == 36);
+    // SSID of the right length, zeroed
+    static const uint8_t zeros[7] = {};
+    frame = beaconWithSsid(zeros, sizeof(zeros));
+    CHECK(BeaconParser::parse(frame.data(), frame.size(), info));
+    CHECK(info.ssid[0] == '\0');
+    CHECK(info.caps.akms == (ApCapabilities::AkmPsk | ApCapabilities::AkmSae));
+}
+
+// 5 GHz beacons may leave out the DS Parameter Set; the HT Operation element names the primary channel.
+static void testChannelFromHtOperation() {
+    BeaconInfo info;
+    std::vector<uint8_t> frame(beaconFrame, beaconFrame + sizeof(beaconFrame));
+    bool removed = false;
+    for (size_t pos = SsidOffset; pos + 2 <= frame.size(); pos += 2 + (size_t)frame[pos + 1]) {
+        if (frame[pos] == InfoElements::IeDsParameterSet) {
+            frame.erase(frame.begin() + (long)pos, frame.begin() + (long)pos + 3);
+            removed = true;
+            break;
+        }
+    }
+    CHECK(removed);
+    CHECK(BeaconParser::parse(frame.data(), frame.size(), info));
+    CHECK(info.channel == 36);
+    // Neither element: unknown
+    std::vector<uint8_t> bare(beaconFrame, beaconFrame + SsidOffset + 9);
+    CHECK(BeaconParser::parse(bare.data(), bare.size(), info));
+    CHECK(strcmp(info.ssid, "iotroam") == 0 && info.channel == 0);
+}
+
+static void testSsidLength() {
+    BeaconInfo info;
+    uint8_t ssid[33];
+    memset(ssid, 'a', sizeof(ssid));
+    std::vector<uint8_t> frame = beaconWithSsid(ssid, 32);
+    CHECK(BeaconParser::parse(frame.data(), frame.size(), info));
+    CHECK(strlen(info.ssid) == 32);
+    frame = beaconWithSsid(ssid, 33);
+    CHECK(!BeaconParser::parse(frame.data(), frame.size(), info));
+}
+
+static void testTruncated() {
+    BeaconInfo info;
+    // Cut inside the last element, and inside the fixed fields
+    CHECK(!BeaconParser::parse(beaconFrame, sizeof(beaconFrame) - 5, info));
+    CHECK(!BeaconParser::parse(beaconFrame, sizeof(beaconFrame) - 1, info));
+    CHECK(!BeaconParser::parse(beaconFrame, SsidOffset + 1, info)); // element header cut in half
+    CHECK(!BeaconParser::parse(beaconFrame, SsidOffset - 1, info));
+    CHECK(!BeaconParser::parse(beaconFrame, 10, info));
+    CHECK(!BeaconParser::parse(nullptr, 0, info));
+    // A length byte running past the end of the frame
+    std::vector<uint8_t> frame(beaconFrame, beaconFrame + sizeof(beaconFrame));
+    frame.push_back(0xdd);
+    frame.push_back(0x20);
+    frame.push_back(0x00);
+    CHECK(!BeaconParser::parse(frame.data(), frame.size(), info));
+    // No elements at all is well-formed
+    CHECK(BeaconParser::parse(beaconFrame, SsidOffset, info));
+    CHECK(info.ssid[0] == '\0' && info.channel == 0);
+}
+
+static void testOtherFrames() {
+    BeaconInfo info;
+    std::vector<uint8_t> frame(beaconFrame, beaconFrame + sizeof(beaconFrame));
+    const uint8_t frameControls[] = {
+        0x08, // data
+        0x88, // QoS data
+        0xd4, // control: ACK
+        0xb4, // control: RTS
+        0x40, // management: probe request
+        0xb0, // management: authentication
+        0x00, // management: association request
+    };
+    for (const uint8_t fc : frameControls) {
+        frame[0] = fc;
+        CHECK(!BeaconParser::parse(frame.data(), frame.size(), info));
+    }
+    static const uint8_t ack[10] = {0xd4, 0x00, 0x00, 0x00, 0x70, 0x90, 0x41, 0x12, 0x8d, 0x51};
+    CHECK(!BeaconParser::parse(ack, sizeof(ack), info));
+}
+
+static BeaconHarvester::Sample sample(uint32_t seq) {
+    BeaconHarvester::Sample s = {};
+    s.bssidKey = 0x709041128d00ULL + seq;
+    s.timeMs = seq;
+    s.rssi = (int8_t)(-40 - (int)(seq % 50));
+    s.channel = 36;
+    return s;
+}
+
+static void testHarvesterRing() {
+    BeaconHarvester harvester;
+    BeaconHarvester::Sample out;
+    CHECK(!harvester.pop(out));
+
+    // FIFO order, also across many wraps of the ring
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 7; i++) {
+            CHECK(harvester.push(sample(pushed++)));
+        }
+        for (int i = 0; i < 7; i++) {
+            CHECK(harvester.pop(out));
+            CHECK(out.timeMs == popped && out.bssidKey == sample(popped).bssidKey && out.rssi == sample(popped).rssi);
+            popped++;
+        }
+    }
+    CHECK(!harvester.pop(out));
+    CHECK(harvester.beacons() == 700);
+    CHECK(harvester.dropped() == 0);
+
+    // Full: further samples are dropped and counted, the queued ones are kept
+    for (uint32_t i = 0; i < BeaconHarvester::Capacity; i++) {
+        CHECK(harvester.push(sample(1000 + i)));
+    }
+    CHECK(!harvester.push(sample(2000)));
+    CHECK(!harvester.push(sample(2001)));
+    CHECK(harvester.dropped() == 2);
+    CHECK(harvester.beacons() == 700 + BeaconHarvester::Capacity);
+    for (uint32_t i = 0; i < BeaconHarvester::Capacity; i++) {
+        CHECK(harvester.pop(out) && out.timeMs == 1000 + i);
+    }
+    CHECK(!harvester.pop(out));
+    CHECK(harvester.push(sample(3000))); // room again
+    CHECK(harvester.pop(out) && out.timeMs == 3000);
+}
+
+static void testHarvesterAirtime() {
+    BeaconHarvester harvester;
+    CHECK(harvester.currentHomeChannel() == 0);
+    harvester.noteFrame(400); // not connected: counted, not busy time
+    harvester.setHomeChannel(36);
+    CHECK(harvester.currentHomeChannel() == 36);
+    harvester.noteFrame(150);
+    harvester.noteFrame(250);
+    CHECK(harvester.frames() == 3);
+    CHECK(harvester.takeBusyUs() == 400);
+    CHECK(harvester.takeBusyUs() == 0);
+    harvester.noteFrame(90);
+    harvester.setHomeChannel(0);
+    harvester.noteFrame(70);
+    CHECK(harvester.takeBusyUs() == 90);
+
+    CHECK(BeaconHarvester::estimateAirtimeUs(300, 6000, false) == 20 + 400);
+    CHECK(BeaconHarvester::estimateAirtimeUs(100, 0, false) == 20 + 134); // unknown rate: 6 Mbps
+    CHECK(BeaconHarvester::estimateAirtimeUs(1500, 144400, true) == 36 + 84);
+}
+
+// The callback and the loop on separate threads: every sample arrives once, in order, or is counted
+// as dropped.
+static void testHarvesterThreads() {
+    static BeaconHarvester harvester;
+    const uint32_t total = 200000;
+    uint32_t rejected = 0;
+    std::thread producer([&rejected] {
+        for (uint32_t seq = 0; seq < total; seq++) {
+            if (!harvester.push(sample(seq))) {
+                rejected++;
+            }
+        }
+    });
+    uint32_t received = 0;
+    uint32_t lastSeq = 0;
+    bool ordered = true;
+    BeaconHarvester::Sample out;
+    while (received + harvester.dropped() < total) {
+        if (harvester.pop(out)) {
+            ordered = ordered && (received == 0 || out.timeMs > lastSeq) && out.bssidKey == sample(out.timeMs).bssidKey;
+            lastSeq = out.timeMs;
+            received++;
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(!harvester.pop(out));
+    CHECK(rejected == harvester.dropped());
+    CHECK(received + rejected == total);
+    CHECK(harvester.beacons() == received);
+}
+
+int main() {
+    testBeacon();
+    testProbeResponse();
+    testHiddenSsid();
+    testChannelFromHtOperation();
+    testSsidLength();
+    testTruncated();
+    testOtherFrames();
+    testHarvesterRing();
+    testHarvesterAirtime();
+    testHarvesterThreads();
+    return hosttest::finish();
+}